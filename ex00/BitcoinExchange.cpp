@@ -1,12 +1,23 @@
 #include "BitcoinExchange.hpp"
+#include "Platform.hpp"
 #include <cstdlib> 
+#include <cstdio>
+#include <cstring>
 #include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <limits>
 #include <iomanip>
+#include <cmath>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/stat.h>
 
-BitcoinExchange::BitcoinExchange(const BitcoinExchange& other) {
+BitcoinExchange::BitcoinExchange(const BitcoinExchange& other)
+    : _dateData(NULL), _rateData(NULL), _rateCount(0), _loadedOffset(0), _rangesStale(true), _loadBytes(0), _loadMicros(0) {
     (void)other;
 }
 
@@ -15,130 +26,761 @@ BitcoinExchange& BitcoinExchange::operator=(const BitcoinExchange& other) {
     return *this;
 }
 
+static long long getTimeMicros() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<long long>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+static const char* findLineEnd(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+// Exact fast path for plain "digits[.digits]" fields: when the mantissa fits
+// in 15 digits and the scale is at most 10^22, both are exact doubles and a
+// single division rounds the same way strtod does. Anything else returns
+// false and goes through strtod.
+static bool parseSimpleDecimal(const char* p, const char* end, double& value) {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    long long mantissa = 0;
+    int digits = 0;
+    int scale = 0;
+    bool seenDot = false;
+
+    if (p == end) return false;
+    for (; p < end; ++p) {
+        if (*p >= '0' && *p <= '9') {
+            if (++digits > 15) return false;
+            mantissa = mantissa * 10 + (*p - '0');
+            if (seenDot) ++scale;
+        } else if (*p == '.' && !seenDot) {
+            seenDot = true;
+        } else {
+            return false;
+        }
+    }
+    if (digits == 0 || scale > 22) return false;
+    value = static_cast<double>(mantissa) / powers[scale];
+    return true;
+}
+
+// strtod needs a terminated string, so short fields are copied to the stack.
+static bool parseRateSlow(const char* rateStr, size_t rateLen, double& value) {
+    char buffer[64];
+    std::string longRate;
+    const char* rateCStr = buffer;
+    if (rateLen < sizeof(buffer)) {
+        std::memcpy(buffer, rateStr, rateLen);
+        buffer[rateLen] = '\0';
+    } else {
+        longRate.assign(rateStr, rateLen);
+        rateCStr = longRate.c_str();
+    }
+
+    char* endPtr;
+    value = std::strtod(rateCStr, &endPtr);
+    return *endPtr == '\0';
+}
+
 void BitcoinExchange::loadDatabase(const std::string& filename) {
-    std::ifstream dbFile(filename.c_str());
-    if (!dbFile.is_open()) {
+    long long start = getTimeMicros();
+
+    MappedFile dbFile;
+    if (!dbFile.open(filename)) {
         throw CouldNotOpenFileException();
     }
-
-    std::string line;
-    if (!std::getline(dbFile, line)) {
-        dbFile.close();
+    if (dbFile.size() == 0) {
         throw std::runtime_error("Database file is empty or header is missing.");
     }
-    if (line != "date,exchange_rate") {
-        std::cerr << "Warning: Unexpected CSV header: " << line << std::endl;
+
+    const char* p = dbFile.data();
+    const char* end = p + dbFile.size();
+    const char* eol = findLineEnd(p, end);
+
+    static const char header[] = "date,exchange_rate";
+    size_t headerLen = sizeof(header) - 1;
+    if (static_cast<size_t>(eol - p) != headerLen || std::memcmp(p, header, headerLen) != 0) {
+        std::cerr << "Warning: Unexpected CSV header: ";
+        std::cerr.write(p, eol - p);
+        std::cerr << std::endl;
+    }
+
+    RateEntries entries;
+    entries.reserve(dbFile.size() / 16);
+    p = eol;
+    _loadedOffset = static_cast<size_t>(eol - dbFile.data());
+    while (p < end) {
+        ++p;
+        _loadedOffset = static_cast<size_t>(p - dbFile.data());
+        if (p >= end) break;
+        eol = findLineEnd(p, end);
+        parseDatabaseLine(p, eol, entries);
+        p = eol;
     }
 
-    while (std::getline(dbFile, line)) {
-        std::stringstream ss(line);
-        std::string dateStr;
-        std::string rateStr;
-        double rate;
+    buildIndex(entries);
+    _delta.clear();
+    _databaseFile = filename;
+    _loadBytes = dbFile.size();
+    _loadMicros = getTimeMicros() - start;
+    if (_rateCount == 0) {
+         throw std::runtime_error("Database file contained no valid data.");
+    }
+}
 
-        if (std::getline(ss, dateStr, ',') && std::getline(ss, rateStr)) {
-            if (dateStr.length() != 10 || dateStr[4] != '-' || dateStr[7] != '-') {
-                 std::cerr << "Warning: Invalid date format in database: " << dateStr << std::endl;
-                 continue;
-            }
+// Parses one "date,rate" row straight out of the mapped file without
+// allocating.
+void BitcoinExchange::parseDatabaseLine(const char* line, const char* end, RateEntries& entries) {
+    const char* comma = static_cast<const char*>(std::memchr(line, ',', static_cast<size_t>(end - line)));
+    if (!comma || comma + 1 == end) {
+        std::cerr << "Warning: Invalid line format in database: ";
+        std::cerr.write(line, end - line);
+        std::cerr << std::endl;
+        return;
+    }
 
-            char* endPtr;
-            rate = std::strtod(rateStr.c_str(), &endPtr);
-            if (*endPtr != '\0' || rateStr.empty()) {
-                std::cerr << "Warning: Invalid rate format in database for date " << dateStr << ": " << rateStr << std::endl;
-                continue;
-            }
-            if (rate < 0) {
-                 std::cerr << "Warning: Negative rate in database for date " << dateStr << ": " << rate << std::endl;
-                 continue;
-            }
+    size_t dateLen = static_cast<size_t>(comma - line);
+    int dateKey = encodeDate(line, dateLen);
+    if (dateKey < 0) {
+        std::cerr << "Warning: Invalid date format in database: ";
+        std::cerr.write(line, dateLen);
+        std::cerr << std::endl;
+        return;
+    }
+
+    const char* rateStr = comma + 1;
+    size_t rateLen = static_cast<size_t>(end - rateStr);
+    double rate;
+    if (!parseSimpleDecimal(rateStr, end, rate) && !parseRateSlow(rateStr, rateLen, rate)) {
+        std::cerr << "Warning: Invalid rate format in database for date ";
+        std::cerr.write(line, dateLen);
+        std::cerr << ": ";
+        std::cerr.write(rateStr, rateLen);
+        std::cerr << std::endl;
+        return;
+    }
+    if (rate < 0) {
+        std::cerr << "Warning: Negative rate in database for date ";
+        std::cerr.write(line, dateLen);
+        std::cerr << ": " << rate << std::endl;
+        return;
+    }
+
+    entries.push_back(std::make_pair(dateKey, rate));
+}
+
+// Calendar check on a packed YYYYMMDD key: month 1-12 and a day that exists
+// in that month, with Gregorian leap years.
+bool BitcoinExchange::isValidDate(int dateKey) {
+    static const int daysInMonth[13] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
 
-            _database[dateStr] = rate;
+    int year = dateKey / 10000;
+    int month = (dateKey / 100) % 100;
+    int day = dateKey % 100;
+
+    if (month < 1 || month > 12 || day < 1) return false;
+    if (day <= daysInMonth[month]) return true;
+    if (month != 2 || day != 29) return false;
+    return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+}
+
+bool BitcoinExchange::isValidValue(const char* valueStr, size_t length, float& value) const {
+    char* endPtr;
+    value = std::strtof(valueStr, &endPtr);
+
+    if (*endPtr != '\0' || length == 0) {
+        return false;
+    }
+
+    if (value == std::numeric_limits<float>::infinity() || value == -std::numeric_limits<float>::infinity()) {
+         return false;
+    }
+
+    if (value < 0) {
+        return false;
+    }
+    if (value > 1000) {
+        return false;
+    }
+
+    return true;
+}
+
+int BitcoinExchange::encodeDate(const std::string& dateStr) {
+    return encodeDate(dateStr.data(), dateStr.length());
+}
+
+// Distance of a byte from '0', wrapped to 0-255.
+static unsigned int digitOffset(char c) {
+    return static_cast<unsigned char>(c - '0');
+}
+
+// Packs a YYYY-MM-DD string into YYYYMMDD, which orders exactly like the
+// string itself. Returns -1 when the string is not in that shape.
+//
+// All eight digits are converted up front and checked together: a byte is a
+// digit exactly when its unsigned offset from '0' is at most 9, so adding 6
+// keeps every valid offset below 16 and pushes anything else past it.
+int BitcoinExchange::encodeDate(const char* dateStr, size_t length) {
+    if (length != 10 || dateStr[4] != '-' || dateStr[7] != '-') {
+        return -1;
+    }
+    unsigned int y0 = digitOffset(dateStr[0]), y1 = digitOffset(dateStr[1]);
+    unsigned int y2 = digitOffset(dateStr[2]), y3 = digitOffset(dateStr[3]);
+    unsigned int m0 = digitOffset(dateStr[5]), m1 = digitOffset(dateStr[6]);
+    unsigned int d0 = digitOffset(dateStr[8]), d1 = digitOffset(dateStr[9]);
+
+    unsigned int check = (y0 + 6) | (y1 + 6) | (y2 + 6) | (y3 + 6)
+                       | (m0 + 6) | (m1 + 6) | (d0 + 6) | (d1 + 6);
+    if (check & ~0xFu) {
+        return -1;
+    }
+    return static_cast<int>(((y0 * 10 + y1) * 10 + y2) * 10 + y3) * 10000
+         + static_cast<int>(m0 * 10 + m1) * 100
+         + static_cast<int>(d0 * 10 + d1);
+}
+
+static bool compareEntryDate(const std::pair<int, double>& a, const std::pair<int, double>& b) {
+    return a.first < b.first;
+}
+
+// Sorts the loaded rows by date and splits them into the parallel arrays.
+// When a date appears more than once the last row in the file wins.
+void BitcoinExchange::buildIndex(RateEntries& entries) {
+    bool sorted = true;
+    for (size_t i = 1; i < entries.size() && sorted; ++i) {
+        sorted = entries[i - 1].first <= entries[i].first;
+    }
+    if (!sorted) {
+        std::stable_sort(entries.begin(), entries.end(), compareEntryDate);
+    }
+
+    _dates.clear();
+    _rates.clear();
+    _snapshot.close();
+    _dates.reserve(entries.size());
+    _rates.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!_dates.empty() && _dates.back() == entries[i].first) {
+            _rates.back() = entries[i].second;
+            continue;
+        }
+        _dates.push_back(entries[i].first);
+        _rates.push_back(entries[i].second);
+    }
+    useVectorStorage();
+    _ranges.build(_rateData, _rateCount);
+    _rangesStale = false;
+}
+
+void BitcoinExchange::useVectorStorage() {
+    _rateCount = _dates.size();
+    _dateData = _rateCount ? &_dates[0] : NULL;
+    _rateData = _rateCount ? &_rates[0] : NULL;
+    _rangesStale = true;
+}
+
+// --- Incremental ingestion ---
+
+// Parses only what was appended to the CSV since the last load or ingest.
+// Rows dated after the end of the table are appended to it directly; older
+// or duplicate dates go to a small delta map that overrides the table and is
+// merged into it once it grows. A partial last line is left for next time.
+// Falls back to a full load if the file shrank or was never read as CSV.
+// Returns the number of rows taken in.
+size_t BitcoinExchange::ingestAppended() {
+    if (_databaseFile.empty() || _loadedOffset == 0) {
+        loadDatabase(_databaseFile.empty() ? std::string("data.csv") : _databaseFile);
+        return _rateCount;
+    }
+
+    MappedFile dbFile;
+    if (!dbFile.open(_databaseFile)) {
+        throw CouldNotOpenFileException();
+    }
+    if (dbFile.size() < _loadedOffset) {
+        loadDatabase(_databaseFile);
+        return _rateCount;
+    }
+
+    const char* begin = dbFile.data() + _loadedOffset;
+    const char* end = dbFile.data() + dbFile.size();
+    RateEntries entries;
+    const char* p = begin;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!eol) break;
+        parseDatabaseLine(p, eol, entries);
+        p = eol + 1;
+    }
+    _loadedOffset = static_cast<size_t>(p - dbFile.data());
+    if (entries.empty()) {
+        return 0;
+    }
+
+    if (_snapshot.data()) {
+        _dates.assign(_dateData, _dateData + _rateCount);
+        _rates.assign(_rateData, _rateData + _rateCount);
+        _snapshot.close();
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (_dates.empty() || entries[i].first > _dates.back()) {
+            _dates.push_back(entries[i].first);
+            _rates.push_back(entries[i].second);
         } else {
-            std::cerr << "Warning: Invalid line format in database: " << line << std::endl;
+            _delta[entries[i].first] = entries[i].second;
         }
     }
+    useVectorStorage();
 
-    dbFile.close();
-    if (_database.empty()) {
-         throw std::runtime_error("Database file contained no valid data.");
+    static const size_t minimumMergeSize = 1024;
+    if (_delta.size() > std::max(minimumMergeSize, _rateCount / 64)) {
+        mergeDelta();
     }
+    return entries.size();
 }
 
-bool BitcoinExchange::isValidDate(const std::string& dateStr) const {
-    if (dateStr.length() != 10) return false;
-    if (dateStr[4] != '-' || dateStr[7] != '-') return false;
+// Folds the delta into the sorted arrays with one linear merge; on equal
+// dates the delta, being newer, wins.
+void BitcoinExchange::mergeDelta() {
+    if (_delta.empty()) {
+        return;
+    }
+
+    std::vector<int> dates;
+    std::vector<double> rates;
+    dates.reserve(_rateCount + _delta.size());
+    rates.reserve(_rateCount + _delta.size());
 
-    for (int i = 0; i < 10; ++i) {
-        if (i == 4 || i == 7) continue;
-        if (!std::isdigit(dateStr[i])) return false;
+    size_t i = 0;
+    std::map<int, double>::const_iterator it = _delta.begin();
+    while (i < _rateCount || it != _delta.end()) {
+        if (it == _delta.end() || (i < _rateCount && _dateData[i] < it->first)) {
+            dates.push_back(_dateData[i]);
+            rates.push_back(_rateData[i]);
+            ++i;
+        } else {
+            if (i < _rateCount && _dateData[i] == it->first) {
+                ++i;
+            }
+            dates.push_back(it->first);
+            rates.push_back(it->second);
+            ++it;
+        }
     }
 
-    int year = std::atoi(dateStr.substr(0, 4).c_str());
-    int month = std::atoi(dateStr.substr(5, 2).c_str());
-    int day = std::atoi(dateStr.substr(8, 2).c_str());
+    _dates.swap(dates);
+    _rates.swap(rates);
+    _snapshot.close();
+    _delta.clear();
+    useVectorStorage();
+}
 
-    if (year < 0) return false;
-    if (month < 1 || month > 12) return false;
-    if (day < 1 || day > 31) return false;
+// Finds the last date <= dateKey. The loop has a fixed trip count for a given
+// table size and the comparison compiles to a conditional move, so there are
+// no unpredictable branches on the hot path.
+bool BitcoinExchange::findRateIndex(int dateKey, size_t& index) const {
+    size_t n = _rateCount;
+    if (n == 0) return false;
 
-    if ((month == 4 || month == 6 || month == 9 || month == 11) && day > 30) {
-        return false;
+    const int* base = _dateData;
+    while (n > 1) {
+        size_t half = n / 2;
+        base = (base[half] <= dateKey) ? base + half : base;
+        n -= half;
     }
-    if (month == 2) {
-        bool isLeap = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
-        if (isLeap && day > 29) {
-            return false;
+    if (*base > dateKey) return false;
+
+    index = static_cast<size_t>(base - _dateData);
+    return true;
+}
+
+// Returns the number of dates <= dateKey, searching forward from `position`
+// (which must already be <= that count). The search gallops 1, 2, 4, ...
+// entries ahead and then bisects, so a run of sorted lookups costs
+// O(m log(n / m)) comparisons overall and never worse than a plain merge.
+size_t BitcoinExchange::advanceRateIndex(size_t position, int dateKey) const {
+    size_t low = position;
+    size_t step = 1;
+    size_t high = position;
+    while (high < _rateCount && _dateData[high] <= dateKey) {
+        low = high + 1;
+        high += step;
+        step *= 2;
+    }
+    if (high > _rateCount) high = _rateCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (_dateData[middle] <= dateKey) {
+            low = middle + 1;
+        } else {
+            high = middle;
         }
-        if (!isLeap && day > 28) {
-            return false;
+    }
+    return low;
+}
+
+struct QueryKeyLess {
+    const std::vector<int>* keys;
+
+    bool operator()(size_t a, size_t b) const {
+        return (*keys)[a] < (*keys)[b];
+    }
+};
+
+// Prices many queries at once. Valid queries are visited in date order (the
+// input order when it is already sorted, otherwise through a sorted index)
+// and merged against the rate table in a single forward pass. Results and
+// statuses are returned in the original query order.
+void BitcoinExchange::queryBatch(const std::vector<Query>& queries, std::vector<QueryResult>& results) const {
+    results.resize(queries.size());
+
+    std::vector<int> keys(queries.size(), -1);
+    std::vector<size_t> order;
+    order.reserve(queries.size());
+    bool sorted = true;
+    int lastKey = -1;
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const Query& query = queries[i];
+        results[i].value = 0;
+        int dateKey = encodeDate(query.date);
+        if (dateKey < 0 || !isValidDate(dateKey)) {
+            results[i].status = QUERY_BAD_DATE;
+        } else if (query.amount < 0) {
+            results[i].status = QUERY_NEGATIVE_VALUE;
+        } else if (query.amount > 1000) {
+            results[i].status = QUERY_TOO_LARGE_VALUE;
+        } else {
+            keys[i] = dateKey;
+            sorted = sorted && dateKey >= lastKey;
+            lastKey = dateKey;
+            order.push_back(i);
         }
     }
 
+    // A table that fits in cache is searched faster than the queries can be
+    // sorted, so unsorted batches only pay for the sort on large tables.
+    // Pending delta rows are not part of the arrays, so they also force the
+    // per-query path.
+    static const size_t cacheResidentRates = 16384;
+    if ((!sorted && _rateCount <= cacheResidentRates) || !_delta.empty()) {
+        for (size_t i = 0; i < order.size(); ++i) {
+            size_t query = order[i];
+            double rate;
+            if (lookupRate(keys[query], rate)) {
+                results[query].status = QUERY_OK;
+                results[query].value = queries[query].amount * rate;
+            } else {
+                results[query].status = QUERY_NO_RATE;
+            }
+        }
+        return;
+    }
+
+    if (!sorted) {
+        QueryKeyLess less;
+        less.keys = &keys;
+        std::stable_sort(order.begin(), order.end(), less);
+    }
+
+    size_t position = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t query = order[i];
+        position = advanceRateIndex(position, keys[query]);
+        if (position == 0) {
+            results[query].status = QUERY_NO_RATE;
+        } else {
+            results[query].status = QUERY_OK;
+            results[query].value = queries[query].amount * _rateData[position - 1];
+        }
+    }
+}
+
+// Rate for the closest date <= dateKey across the table and the delta.
+bool BitcoinExchange::lookupRate(int dateKey, double& rate) const {
+    size_t index;
+    bool found = findRateIndex(dateKey, index);
+    if (!_delta.empty()) {
+        std::map<int, double>::const_iterator it = _delta.upper_bound(dateKey);
+        if (it != _delta.begin()) {
+            --it;
+            if (!found || it->first >= _dateData[index]) {
+                rate = it->second;
+                return true;
+            }
+        }
+    }
+    if (found) {
+        rate = _rateData[index];
+    }
+    return found;
+}
+
+// Aggregates the rates dated within [fromKey, toKey]. Uses the range index
+// when it is current; after an ingest it merge-scans the table and the delta
+// instead, so the answer is the same either way.
+bool BitcoinExchange::rangeStats(int fromKey, int toKey, RangeIndex::Stats& stats) const {
+    size_t first = 0;
+    size_t last = 0;
+    size_t index;
+    if (findRateIndex(fromKey - 1, index)) first = index + 1;
+    if (findRateIndex(toKey, index)) last = index + 1;
+    if (!_rangesStale) {
+        return _ranges.stats(first, last, stats);
+    }
+
+    std::map<int, double>::const_iterator it = _delta.lower_bound(fromKey);
+    std::map<int, double>::const_iterator stop = _delta.upper_bound(toKey);
+    long double sum = 0;
+    stats.count = 0;
+    size_t i = first;
+    while (i < last || it != stop) {
+        double value;
+        if (it == stop || (i < last && _dateData[i] < it->first)) {
+            value = _rateData[i++];
+        } else {
+            if (i < last && _dateData[i] == it->first) {
+                ++i;
+            }
+            value = it->second;
+            ++it;
+        }
+        if (stats.count == 0 || value < stats.min) stats.min = value;
+        if (stats.count == 0 || value > stats.max) stats.max = value;
+        sum += value;
+        ++stats.count;
+    }
+    if (stats.count == 0) {
+        return false;
+    }
+    stats.sum = static_cast<double>(sum);
+    stats.mean = static_cast<double>(sum / static_cast<long double>(stats.count));
     return true;
 }
 
-bool BitcoinExchange::isValidValue(const std::string& valueStr, float& value) const {
-    char* endPtr;
-    value = std::strtof(valueStr.c_str(), &endPtr);
+// Folds pending delta rows in and rebuilds the range index if the table
+// changed since it was last built.
+void BitcoinExchange::prepareRanges() {
+    if (!_rangesStale) {
+        return;
+    }
+    mergeDelta();
+    _ranges.build(_rateData, _rateCount);
+    _rangesStale = false;
+}
+
+// Min, max, sum and mean of the rates recorded between two dates, both
+// inclusive. Returns false if no rate falls inside the window.
+bool BitcoinExchange::queryRange(const std::string& from, const std::string& to, RangeIndex::Stats& stats) {
+    int fromKey = encodeDate(from);
+    int toKey = encodeDate(to);
+    if (fromKey < 0 || !isValidDate(fromKey) || toKey < 0 || !isValidDate(toKey)) {
+        throw InvalidDateException();
+    }
+    if (fromKey > toKey) {
+        throw BadInputException();
+    }
+    prepareRanges();
+    return rangeStats(fromKey, toKey, stats);
+}
+
+double BitcoinExchange::getRate(const std::string& date) const {
+    double rate;
+    int dateKey = encodeDate(date);
+    if (dateKey < 0 || !lookupRate(dateKey, rate)) {
+        throw std::runtime_error("No data available for or prior to this date.");
+    }
+    return rate;
+}
+
+// --- Binary snapshot ---
+//
+// Layout, native byte order:
+//   SnapshotHeader (24 bytes)
+//   int32  dates[count]      sorted YYYYMMDD keys
+//   padding up to a multiple of 8
+//   double rates[count]
+// The checksum covers the date and rate sections.
+
+static const char snapshotMagic[8] = { 'B', 'T', 'C', 'S', 'N', 'A', 'P', '\0' };
+static const uint32_t snapshotVersion = 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t checksum;
+};
+
+static size_t snapshotRatesOffset(size_t count) {
+    size_t offset = sizeof(SnapshotHeader) + count * sizeof(int32_t);
+    return (offset + 7) & ~static_cast<size_t>(7);
+}
 
-    if (*endPtr != '\0' || valueStr.empty()) {
+// FNV-1a style mixing over 64-bit words; the tail is zero padded.
+static uint64_t snapshotChecksum(uint64_t hash, const char* data, size_t length) {
+    const uint64_t prime = 1099511628211ULL;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * prime;
+    }
+    if (i < length) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, length - i);
+        hash = (hash ^ word) * prime;
+    }
+    return hash;
+}
+
+static uint64_t snapshotChecksum(const int* dates, const double* rates, size_t count) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = snapshotChecksum(hash, reinterpret_cast<const char*>(dates), count * sizeof(int32_t));
+    hash = snapshotChecksum(hash, reinterpret_cast<const char*>(rates), count * sizeof(double));
+    return hash;
+}
+
+std::string BitcoinExchange::snapshotPath(const std::string& databaseFile) {
+    std::string::size_type length = databaseFile.length();
+    if (length >= 4 && databaseFile.compare(length - 4, 4, ".csv") == 0) {
+        return databaseFile.substr(0, length - 4) + ".snap";
+    }
+    return databaseFile + ".snap";
+}
+
+// The snapshot must be strictly newer: file times advance in clock ticks,
+// so a CSV rewritten just after the snapshot can carry the same time.
+static bool isSnapshotFresh(const std::string& snapshotFile, const std::string& databaseFile) {
+    struct stat snapshotStat;
+    struct stat databaseStat;
+    if (stat(snapshotFile.c_str(), &snapshotStat) < 0) {
         return false;
     }
+    if (stat(databaseFile.c_str(), &databaseStat) < 0) {
+        return true;
+    }
+    if (snapshotStat.st_mtime != databaseStat.st_mtime) {
+        return snapshotStat.st_mtime > databaseStat.st_mtime;
+    }
+    return STAT_MTIME_NSEC(snapshotStat) > STAT_MTIME_NSEC(databaseStat);
+}
 
-    if (value == std::numeric_limits<float>::infinity() || value == -std::numeric_limits<float>::infinity()) {
-         return false;
+// A fresh snapshot covers every complete line of the CSV, so ingestion can
+// resume after the last newline. Only the tail of the mapping is touched.
+static size_t completeLinesLength(const std::string& databaseFile) {
+    MappedFile dbFile;
+    if (!dbFile.open(databaseFile)) {
+        return 0;
     }
+    size_t length = dbFile.size();
+    while (length > 0 && dbFile.data()[length - 1] != '\n') {
+        --length;
+    }
+    return length;
+}
 
-    if (value < 0) {
+// Maps a snapshot and points the lookup arrays straight into it. Returns
+// false, leaving the exchange empty, if the file is missing or corrupt.
+bool BitcoinExchange::loadSnapshot(const std::string& filename) {
+    long long start = getTimeMicros();
+
+    if (!_snapshot.open(filename)) {
         return false;
     }
-    if (value > 1000) {
+
+    SnapshotHeader header;
+    bool valid = _snapshot.size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, _snapshot.data(), sizeof(header));
+        valid = std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) == 0
+            && header.version == snapshotVersion
+            && header.count > 0
+            && _snapshot.size() == snapshotRatesOffset(header.count) + header.count * sizeof(double);
+    }
+    if (valid) {
+        const int* dates = reinterpret_cast<const int*>(_snapshot.data() + sizeof(header));
+        const double* rates = reinterpret_cast<const double*>(_snapshot.data() + snapshotRatesOffset(header.count));
+        valid = snapshotChecksum(dates, rates, header.count) == header.checksum;
+        if (valid) {
+            _dates.clear();
+            _rates.clear();
+            _dateData = dates;
+            _rateData = rates;
+            _rateCount = header.count;
+            _rangesStale = true;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Warning: Ignoring invalid snapshot: " << filename << std::endl;
+        _snapshot.close();
         return false;
     }
 
+    _loadBytes = _snapshot.size();
+    _loadMicros = getTimeMicros() - start;
     return true;
 }
 
-double BitcoinExchange::getRate(const std::string& date) const {
-    std::map<std::string, double>::const_iterator it = _database.find(date);
-    if (it != _database.end()) {
-        return it->second;
+// Writes the current rate table as a snapshot. The file is written under a
+// temporary name and renamed so readers never see a partial snapshot.
+void BitcoinExchange::writeSnapshot(const std::string& filename) const {
+    if (_rateCount == 0) {
+        throw std::runtime_error("Database is not loaded or empty.");
     }
 
-    it = _database.upper_bound(date);
+    SnapshotHeader header;
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.count = static_cast<uint32_t>(_rateCount);
+    header.checksum = snapshotChecksum(_dateData, _rateData, _rateCount);
 
-    if (it == _database.begin()) {
-        throw std::runtime_error("No data available for or prior to this date.");
+    std::string tmpFile = filename + ".tmp";
+    std::ofstream out(tmpFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw CouldNotOpenFileException();
     }
 
-    --it;
-    return it->second;
+    static const char padding[8] = { 0 };
+    size_t datesEnd = sizeof(header) + _rateCount * sizeof(int32_t);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(_dateData), _rateCount * sizeof(int32_t));
+    out.write(padding, snapshotRatesOffset(_rateCount) - datesEnd);
+    out.write(reinterpret_cast<const char*>(_rateData), _rateCount * sizeof(double));
+    out.close();
+
+    if (!out || std::rename(tmpFile.c_str(), filename.c_str()) != 0) {
+        std::remove(tmpFile.c_str());
+        throw std::runtime_error("Could not write snapshot file.");
+    }
+}
+
+BitcoinExchange::BitcoinExchange()
+    : _dateData(NULL), _rateData(NULL), _rateCount(0), _loadedOffset(0), _rangesStale(true), _loadBytes(0), _loadMicros(0) {
+    loadRates("data.csv");
+}
+
+BitcoinExchange::BitcoinExchange(const std::string& databaseFile)
+    : _dateData(NULL), _rateData(NULL), _rateCount(0), _loadedOffset(0), _rangesStale(true), _loadBytes(0), _loadMicros(0) {
+    loadRates(databaseFile);
 }
 
-BitcoinExchange::BitcoinExchange() {
+// Prefers the binary snapshot next to the CSV unless the CSV has been
+// modified since the snapshot was written or the snapshot does not verify.
+void BitcoinExchange::loadRates(const std::string& databaseFile) {
     try {
-        loadDatabase("data.csv");
+        std::string snapshotFile = snapshotPath(databaseFile);
+        _databaseFile = databaseFile;
+        if (isSnapshotFresh(snapshotFile, databaseFile) && loadSnapshot(snapshotFile)) {
+            _loadedOffset = completeLinesLength(databaseFile);
+            return;
+        }
+        loadDatabase(databaseFile);
     } catch (const std::exception& e) {
         std::cerr << "Error loading database: " << e.what() << std::endl;
     }
@@ -146,87 +788,519 @@ BitcoinExchange::BitcoinExchange() {
 
 BitcoinExchange::~BitcoinExchange() {}
 
+bool BitcoinExchange::isLoaded() const {
+    return _rateCount > 0;
+}
+
+double BitcoinExchange::getLoadThroughput() const {
+    if (_loadMicros <= 0) return 0.0;
+    return (static_cast<double>(_loadBytes) / (1024.0 * 1024.0)) / (static_cast<double>(_loadMicros) / 1000000.0);
+}
+
+void BitcoinExchange::printLoadStats() const {
+    std::cerr << "Database: " << _loadBytes << " bytes loaded in " << _loadMicros
+              << " us (" << getLoadThroughput() << " MB/s)" << std::endl;
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+static const char* skipToken(const char* p, const char* end) {
+    while (p < end && !isSpace(*p)) ++p;
+    return p;
+}
+
+// Formats like printf("%g") for finite values whose rounding to six
+// significant digits is unambiguous. The scaled value is computed in long
+// double with a single rounding, so it is only trusted when it is not within
+// a tiny margin of a rounding tie; otherwise the caller falls back to printf.
+static bool formatGeneralFast(char* buffer, double value, size_t& length) {
+    static const long double powers[] = {
+        1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L,
+        1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+        1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+    };
+    char* out = buffer;
+    if (value != value || value == 0.0) return false;
+    if (value < 0) {
+        *out++ = '-';
+        value = -value;
+    }
+    if (value > 1e300) return false;
+
+    // log10(2) * binary exponent is within one of the decimal exponent.
+    int binaryExponent;
+    std::frexp(value, &binaryExponent);
+    int exponent = static_cast<int>(std::floor((binaryExponent - 1) * 0.30102999566398120));
+    int shift = 5 - exponent;
+    if (shift > 26 || shift < -26) return false;
+
+    long double scaled = shift >= 0 ? value * powers[shift] : value / powers[-shift];
+    if (scaled >= 1e6L) {
+        --shift;
+        ++exponent;
+        scaled = shift >= 0 ? value * powers[shift] : value / powers[-shift];
+    } else if (scaled < 1e5L) {
+        ++shift;
+        --exponent;
+        scaled = shift >= 0 ? value * powers[shift] : value / powers[-shift];
+    }
+    if (scaled < 1e5L || scaled >= 1e6L) return false;
+
+    long whole = static_cast<long>(scaled);
+    long double fraction = scaled - whole;
+    if (fraction > 0.5L - 1e-9L && fraction < 0.5L + 1e-9L) return false;
+
+    long digits = whole + (fraction > 0.5L ? 1 : 0);
+    if (digits == 1000000) {
+        digits = 100000;
+        ++exponent;
+    }
+
+    char text[6];
+    for (int i = 5; i >= 0; --i) {
+        text[i] = static_cast<char>('0' + digits % 10);
+        digits /= 10;
+    }
+    int significant = 6;
+    while (significant > 1 && text[significant - 1] == '0') --significant;
+
+    if (exponent < -4 || exponent >= 6) {
+        *out++ = text[0];
+        if (significant > 1) {
+            *out++ = '.';
+            for (int i = 1; i < significant; ++i) *out++ = text[i];
+        }
+        *out++ = 'e';
+        *out++ = exponent < 0 ? '-' : '+';
+        int absExponent = exponent < 0 ? -exponent : exponent;
+        if (absExponent >= 100) *out++ = static_cast<char>('0' + absExponent / 100);
+        *out++ = static_cast<char>('0' + (absExponent / 10) % 10);
+        *out++ = static_cast<char>('0' + absExponent % 10);
+    } else if (exponent < 0) {
+        *out++ = '0';
+        *out++ = '.';
+        for (int i = -1; i > exponent; --i) *out++ = '0';
+        for (int i = 0; i < significant; ++i) *out++ = text[i];
+    } else {
+        for (int i = 0; i <= exponent; ++i) *out++ = text[i];
+        if (significant > exponent + 1) {
+            *out++ = '.';
+            for (int i = exponent + 1; i < significant; ++i) *out++ = text[i];
+        }
+    }
+    length = static_cast<size_t>(out - buffer);
+    return true;
+}
+
+// Same text std::ostream produces for a double with the default flags.
+static size_t formatNumber(char* buffer, size_t size, double value) {
+    size_t length;
+    if (formatGeneralFast(buffer, value, length)) {
+        return length;
+    }
+    int written = std::snprintf(buffer, size, "%g", value);
+    return written > 0 ? static_cast<size_t>(written) : 0;
+}
+
+// Exact fast path for plain "[sign]digits[.digits]" values: a mantissa of at
+// most seven digits and a power of ten up to 1e10 are both exact floats, so
+// one float division rounds exactly like strtof.
+static bool parseSimpleFloat(const char* p, const char* end, float& value) {
+    static const float powers[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+    };
+    long mantissa = 0;
+    int digits = 0;
+    int scale = 0;
+    bool seenDot = false;
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    for (; p < end; ++p) {
+        if (*p >= '0' && *p <= '9') {
+            if (++digits > 7) return false;
+            mantissa = mantissa * 10 + (*p - '0');
+            if (seenDot) ++scale;
+        } else if (*p == '.' && !seenDot) {
+            seenDot = true;
+        } else {
+            return false;
+        }
+    }
+    if (digits == 0 || scale > 10) return false;
+    value = static_cast<float>(mantissa) / powers[scale];
+    if (negative) value = -value;
+    return true;
+}
+
+static void writeBadInput(OutputBuffer& out, const char* text, size_t length) {
+    out.write(OutputBuffer::ERR, "Error: bad input => ");
+    out.write(OutputBuffer::ERR, text, length);
+    out.write(OutputBuffer::ERR, "\n", 1);
+}
+
+// Handles one "date | value" line, tokenizing it in place. The line is never
+// modified, so it can point straight into a shared read-only mapping.
+void BitcoinExchange::processLine(const char* line, const char* end, OutputBuffer& out) const {
+    const char* tokens[3];
+    const char* tokenEnds[3];
+    const char* p = line;
+    int count = 0;
+
+    while (count < 3) {
+        p = skipSpaces(p, end);
+        if (p == end) break;
+        tokens[count] = p;
+        p = skipToken(p, end);
+        tokenEnds[count] = p;
+        ++count;
+    }
+
+    size_t lineLength = static_cast<size_t>(end - line);
+    if (count == 3 && tokenEnds[1] - tokens[1] == 2 && tokens[1][0] == '.' && tokens[1][1] == '.') {
+        if (skipSpaces(p, end) != end) {
+            writeBadInput(out, line, lineLength);
+            return;
+        }
+        processRange(line, end, tokens, tokenEnds, out);
+        return;
+    }
+    if (count < 3 || tokenEnds[1] - tokens[1] != 1 || *tokens[1] != '|') {
+        const char* q = line;
+        while (q < end && (*q == ' ' || *q == '\t' || *q == '\r')) ++q;
+        if (q != end) {
+            writeBadInput(out, line, lineLength);
+        }
+        return;
+    }
+    if (skipSpaces(p, end) != end) {
+        writeBadInput(out, line, lineLength);
+        return;
+    }
+
+    const char* date = tokens[0];
+    size_t dateLength = static_cast<size_t>(tokenEnds[0] - tokens[0]);
+    int dateKey = encodeDate(date, dateLength);
+    if (dateKey < 0 || !isValidDate(dateKey)) {
+        writeBadInput(out, date, dateLength);
+        return;
+    }
+
+    // A value that parses on the fast path is exact, so it can be range
+    // checked directly; the strtof/strtod pair is only needed otherwise.
+    const char* valueStr = tokens[2];
+    float value;
+    bool validValue;
+    double checkValue = 0;
+    bool numeric = true;
+    if (parseSimpleFloat(valueStr, tokenEnds[2], value)) {
+        checkValue = value;
+        validValue = !(value < 0) && !(value > 1000);
+    } else {
+        // strtof needs a terminated copy of the token.
+        size_t valueLength = static_cast<size_t>(tokenEnds[2] - valueStr);
+        std::string valueCopy(valueStr, valueLength);
+        validValue = isValidValue(valueCopy.c_str(), valueLength, value);
+        if (!validValue) {
+            char* endPtr;
+            checkValue = std::strtod(valueCopy.c_str(), &endPtr);
+            numeric = (*endPtr == '\0');
+        }
+    }
+
+    if (!validValue) {
+        if (numeric && checkValue < 0) {
+            out.write(OutputBuffer::ERR, "Error: not a positive number.\n");
+        } else if (numeric && checkValue > 1000) {
+            out.write(OutputBuffer::ERR, "Error: too large a number.\n");
+        } else {
+            writeBadInput(out, line, lineLength);
+        }
+        return;
+    }
+
+    double rate;
+    if (!lookupRate(dateKey, rate)) {
+        out.write(OutputBuffer::ERR, "Error: No data available for or prior to this date. (for date: ");
+        out.write(OutputBuffer::ERR, date, dateLength);
+        out.write(OutputBuffer::ERR, ")\n", 2);
+        return;
+    }
+
+    char number[64];
+    double result = value * rate;
+    out.write(OutputBuffer::OUT, date, dateLength);
+    out.write(OutputBuffer::OUT, " => ", 4);
+    out.write(OutputBuffer::OUT, number, formatNumber(number, sizeof(number), value));
+    out.write(OutputBuffer::OUT, " = ", 3);
+    out.write(OutputBuffer::OUT, number, formatNumber(number, sizeof(number), result));
+    out.write(OutputBuffer::OUT, "\n", 1);
+}
+
+// Handles a "from .. to" line: prints the aggregates of the window.
+void BitcoinExchange::processRange(const char* line, const char* end, const char* const* tokens,
+                                   const char* const* tokenEnds, OutputBuffer& out) const {
+    size_t fromLength = static_cast<size_t>(tokenEnds[0] - tokens[0]);
+    size_t toLength = static_cast<size_t>(tokenEnds[2] - tokens[2]);
+    int fromKey = encodeDate(tokens[0], fromLength);
+    if (fromKey < 0 || !isValidDate(fromKey)) {
+        writeBadInput(out, tokens[0], fromLength);
+        return;
+    }
+    int toKey = encodeDate(tokens[2], toLength);
+    if (toKey < 0 || !isValidDate(toKey)) {
+        writeBadInput(out, tokens[2], toLength);
+        return;
+    }
+    if (fromKey > toKey) {
+        writeBadInput(out, line, static_cast<size_t>(end - line));
+        return;
+    }
+
+    RangeIndex::Stats stats;
+    if (!rangeStats(fromKey, toKey, stats)) {
+        out.write(OutputBuffer::ERR, "Error: No data available in this range. (for range: ");
+        out.write(OutputBuffer::ERR, tokens[0], fromLength);
+        out.write(OutputBuffer::ERR, " .. ", 4);
+        out.write(OutputBuffer::ERR, tokens[2], toLength);
+        out.write(OutputBuffer::ERR, ")\n", 2);
+        return;
+    }
+
+    char number[64];
+    out.write(OutputBuffer::OUT, tokens[0], fromLength);
+    out.write(OutputBuffer::OUT, " .. ", 4);
+    out.write(OutputBuffer::OUT, tokens[2], toLength);
+    out.write(OutputBuffer::OUT, " => min = ", 10);
+    out.write(OutputBuffer::OUT, number, formatNumber(number, sizeof(number), stats.min));
+    out.write(OutputBuffer::OUT, ", max = ", 8);
+    out.write(OutputBuffer::OUT, number, formatNumber(number, sizeof(number), stats.max));
+    out.write(OutputBuffer::OUT, ", mean = ", 9);
+    out.write(OutputBuffer::OUT, number, formatNumber(number, sizeof(number), stats.mean));
+    out.write(OutputBuffer::OUT, ", sum = ", 8);
+    out.write(OutputBuffer::OUT, number, formatNumber(number, sizeof(number), stats.sum));
+    out.write(OutputBuffer::OUT, ", count = ", 10);
+    int length = std::snprintf(number, sizeof(number), "%lu", static_cast<unsigned long>(stats.count));
+    out.write(OutputBuffer::OUT, number, static_cast<size_t>(length));
+    out.write(OutputBuffer::OUT, "\n", 1);
+}
+
 void BitcoinExchange::processInput(const std::string& filename) {
-    std::ifstream inputFile(filename.c_str());
-    if (!inputFile.is_open()) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
         std::cerr << "Error: could not open file." << std::endl;
         return;
     }
-    if (_database.empty()) {
+    if (_rateCount == 0) {
         std::cerr << "Error: Database is not loaded or empty." << std::endl;
-        inputFile.close();
+        close(fd);
         return;
     }
+    prepareRanges();
+
+    static const size_t readSize = 1 << 20;
+    static const size_t flushSize = 1 << 16;
+
+    std::vector<char> buffer(readSize);
+    OutputBuffer out;
+    size_t used = 0;
+    bool readAnything = false;
+    bool headerSkipped = false;
+    bool eof = false;
+
+    while (!eof) {
+        if (used == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        ssize_t n = read(fd, &buffer[used], buffer.size() - used);
+        if (n <= 0) {
+            eof = true;
+        } else {
+            used += static_cast<size_t>(n);
+            readAnything = true;
+        }
 
-    std::string line;
-    if (!std::getline(inputFile, line)) {
+        char* p = &buffer[0];
+        char* dataEnd = p + used;
+        while (p < dataEnd) {
+            char* nl = static_cast<char*>(std::memchr(p, '\n', static_cast<size_t>(dataEnd - p)));
+            if (!nl) {
+                if (!eof) break;
+                nl = dataEnd;
+            }
+            if (headerSkipped) {
+                processLine(p, nl, out);
+            }
+            headerSkipped = true;
+            p = nl + 1;
+            if (out.size() >= flushSize) {
+                out.flush();
+            }
+        }
+        if (p < dataEnd) {
+            used = static_cast<size_t>(dataEnd - p);
+            std::memmove(&buffer[0], p, used);
+        } else {
+            used = 0;
+        }
+    }
+    close(fd);
+
+    if (!readAnything) {
         std::cerr << "Error: Input file is empty." << std::endl;
-        inputFile.close();
         return;
     }
+    out.flush();
+}
 
-    while (std::getline(inputFile, line)) {
-        std::stringstream ss(line);
-        std::string dateStr;
-        std::string separator;
-        std::string valueStr;
-        float value;
+// Shared state of one processInputParallel run. Workers claim chunks in
+// order and may run at most `window` chunks ahead of the writer, which
+// bounds the amount of buffered output.
+struct BitcoinExchange::ParallelJob {
+    const BitcoinExchange* exchange;
+    std::vector<const char*> bounds;
+    std::vector<OutputBuffer*> results;
+    size_t next;
+    size_t written;
+    size_t window;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+};
 
-        if (!(ss >> dateStr >> separator >> valueStr) || separator != "|") {
-             std::string trimmedLine = line;
-             trimmedLine.erase(0, trimmedLine.find_first_not_of(" \t\n\r"));
-             trimmedLine.erase(trimmedLine.find_last_not_of(" \t\n\r") + 1);
-             if (!trimmedLine.empty()) {
-                std::cerr << "Error: bad input => " << line << std::endl;
-             }
-            continue;
+void* BitcoinExchange::processChunks(void* arg) {
+    ParallelJob& job = *static_cast<ParallelJob*>(arg);
+    size_t chunkCount = job.results.size();
+
+    while (true) {
+        pthread_mutex_lock(&job.mutex);
+        while (job.next < chunkCount && job.next >= job.written + job.window) {
+            pthread_cond_wait(&job.changed, &job.mutex);
         }
+        if (job.next >= chunkCount) {
+            pthread_mutex_unlock(&job.mutex);
+            break;
+        }
+        size_t index = job.next++;
+        pthread_mutex_unlock(&job.mutex);
 
-        std::string remaining;
-        if (ss >> remaining) {
-             std::cerr << "Error: bad input => " << line << std::endl;
-             continue;
+        OutputBuffer* out = new OutputBuffer();
+        const char* p = job.bounds[index];
+        const char* end = job.bounds[index + 1];
+        while (p < end) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!nl) nl = end;
+            job.exchange->processLine(p, nl, *out);
+            p = nl + 1;
         }
 
-        dateStr.erase(0, dateStr.find_first_not_of(" \t"));
-        dateStr.erase(dateStr.find_last_not_of(" \t") + 1);
-        valueStr.erase(0, valueStr.find_first_not_of(" \t"));
-        valueStr.erase(valueStr.find_last_not_of(" \t") + 1);
+        pthread_mutex_lock(&job.mutex);
+        job.results[index] = out;
+        pthread_cond_broadcast(&job.changed);
+        pthread_mutex_unlock(&job.mutex);
+    }
+    return NULL;
+}
 
-        if (!isValidDate(dateStr)) {
-            std::cerr << "Error: bad input => " << dateStr << std::endl;
-            continue;
+// Same output as processInput, but the file is mapped, cut into
+// newline-aligned chunks and priced by `threadCount` workers. Chunks are
+// written back in file order by the calling thread.
+void BitcoinExchange::processInputParallel(const std::string& filename, int threadCount) {
+    MappedFile inputFile;
+    if (!inputFile.open(filename)) {
+        std::cerr << "Error: could not open file." << std::endl;
+        return;
+    }
+    if (_rateCount == 0) {
+        std::cerr << "Error: Database is not loaded or empty." << std::endl;
+        return;
+    }
+    if (inputFile.size() == 0) {
+        std::cerr << "Error: Input file is empty." << std::endl;
+        return;
+    }
+    prepareRanges();
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+
+    static const size_t chunkSize = 4 << 20;
+
+    const char* begin = inputFile.data();
+    const char* end = begin + inputFile.size();
+    const char* header = static_cast<const char*>(std::memchr(begin, '\n', inputFile.size()));
+    if (!header) {
+        return;
+    }
+
+    ParallelJob job;
+    job.exchange = this;
+    job.next = 0;
+    job.written = 0;
+    job.window = static_cast<size_t>(threadCount) * 4;
+
+    const char* p = header + 1;
+    job.bounds.push_back(p);
+    while (p < end) {
+        const char* cut = p + std::min(chunkSize, static_cast<size_t>(end - p));
+        if (cut < end) {
+            const char* nl = static_cast<const char*>(std::memchr(cut, '\n', static_cast<size_t>(end - cut)));
+            cut = nl ? nl + 1 : end;
         }
+        job.bounds.push_back(cut);
+        p = cut;
+    }
+    job.results.assign(job.bounds.size() - 1, NULL);
 
-        if (!isValidValue(valueStr, value)) {
-            char* endPtr;
-            double checkValue = std::strtod(valueStr.c_str(), &endPtr);
-             if (*endPtr != '\0' || valueStr.empty()) {
-                 std::cerr << "Error: bad input => " << line << std::endl;
-             }
-             else if (checkValue < 0) {
-                std::cerr << "Error: not a positive number." << std::endl;
-            } else if (checkValue > 1000) {
-                std::cerr << "Error: too large a number." << std::endl;
-            } else {
-                 std::cerr << "Error: bad input => " << line << std::endl;
-            }
-            continue;
+    pthread_mutex_init(&job.mutex, NULL);
+    pthread_cond_init(&job.changed, NULL);
+
+    std::vector<pthread_t> threads(threadCount);
+    int started = 0;
+    for (int i = 0; i < threadCount; ++i) {
+        if (pthread_create(&threads[started], NULL, &BitcoinExchange::processChunks, &job) == 0) {
+            ++started;
         }
+    }
+    if (started == 0) {
+        job.window = job.results.size();
+        processChunks(&job);
+    }
 
-        try {
-            double rate = getRate(dateStr);
-            double result = value * rate;
-            std::cout << dateStr << " => " << value << " = " << result << std::endl;
-        } catch (const std::exception& e) {
-            std::cerr << "Error: " << e.what() << " (for date: " << dateStr << ")" << std::endl;
+    for (size_t i = 0; i < job.results.size(); ++i) {
+        pthread_mutex_lock(&job.mutex);
+        while (job.results[i] == NULL) {
+            pthread_cond_wait(&job.changed, &job.mutex);
         }
+        OutputBuffer* out = job.results[i];
+        pthread_mutex_unlock(&job.mutex);
+
+        out->flush();
+        delete out;
+
+        pthread_mutex_lock(&job.mutex);
+        job.results[i] = NULL;
+        job.written = i + 1;
+        pthread_cond_broadcast(&job.changed);
+        pthread_mutex_unlock(&job.mutex);
     }
 
-    inputFile.close();
+    for (int i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_cond_destroy(&job.changed);
+    pthread_mutex_destroy(&job.mutex);
 }
 
-
 const char* BitcoinExchange::CouldNotOpenFileException::what() const throw() {
     return "could not open file.";
 }
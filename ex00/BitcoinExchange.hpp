@@ -3,17 +3,60 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <map>
+#include <utility>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include "OutputBuffer.hpp"
+#include "MappedFile.hpp"
+#include "RangeIndex.hpp"
 
 class BitcoinExchange {
 public:
+    enum QueryStatus {
+        QUERY_OK,
+        QUERY_BAD_DATE,
+        QUERY_NEGATIVE_VALUE,
+        QUERY_TOO_LARGE_VALUE,
+        QUERY_NO_RATE
+    };
+
+    struct Query {
+        std::string date;
+        double amount;
+    };
+
+    struct QueryResult {
+        double value;
+        QueryStatus status;
+    };
+
     BitcoinExchange();
+    explicit BitcoinExchange(const std::string& databaseFile);
     ~BitcoinExchange();
 
     void processInput(const std::string& filename);
+    void processInputParallel(const std::string& filename, int threadCount);
+    void queryBatch(const std::vector<Query>& queries, std::vector<QueryResult>& results) const;
+    void processLine(const char* line, const char* end, OutputBuffer& out) const;
+    bool isLoaded() const;
+
+    double getLoadThroughput() const;
+    void printLoadStats() const;
+    void writeSnapshot(const std::string& filename) const;
+    size_t ingestAppended();
+    void mergeDelta();
+    void prepareRanges();
+    bool queryRange(const std::string& from, const std::string& to, RangeIndex::Stats& stats);
+    double getRate(const std::string& date) const;
+
+    static std::string snapshotPath(const std::string& databaseFile);
+    // YYYY-MM-DD packed as YYYYMMDD, or -1; isValidDate checks the calendar.
+    static int encodeDate(const std::string& dateStr);
+    static int encodeDate(const char* dateStr, size_t length);
+    static bool isValidDate(int dateKey);
 
     class CouldNotOpenFileException : public std::exception {
     public:
@@ -41,15 +84,53 @@ public:
     };
 
 private:
-    std::map<std::string, double> _database;
+    // Rates sorted by date, stored as two parallel packed arrays so that
+    // lookups binary-search plain integers instead of walking a tree.
+    std::vector<int> _dates;
+    std::vector<double> _rates;
+
+    // The arrays lookups actually read: either the vectors above or the
+    // sections of a memory-mapped snapshot.
+    MappedFile _snapshot;
+    const int* _dateData;
+    const double* _rateData;
+    size_t _rateCount;
+
+    // Incremental ingestion: the CSV and how far of it has been parsed, plus
+    // rows that arrived out of date order and wait to be merged in.
+    std::string _databaseFile;
+    size_t _loadedOffset;
+    std::map<int, double> _delta;
+
+    // Window aggregates over the table. Built with the table on a CSV load
+    // and otherwise on demand; stale after a snapshot load or an ingest.
+    RangeIndex _ranges;
+    bool _rangesStale;
+
+    size_t _loadBytes;
+    long long _loadMicros;
 
     BitcoinExchange(const BitcoinExchange& other);
     BitcoinExchange& operator=(const BitcoinExchange& other);
 
+    void loadRates(const std::string& databaseFile);
     void loadDatabase(const std::string& filename);
-    bool isValidDate(const std::string& dateStr) const;
-    bool isValidValue(const std::string& valueStr, float& value) const;
-    double getRate(const std::string& date) const;
+    bool loadSnapshot(const std::string& filename);
+    bool isValidValue(const char* valueStr, size_t length, float& value) const;
+
+    struct ParallelJob;
+    static void* processChunks(void* arg);
+
+    typedef std::vector<std::pair<int, double> > RateEntries;
+    void parseDatabaseLine(const char* line, const char* end, RateEntries& entries);
+    void buildIndex(RateEntries& entries);
+    bool findRateIndex(int dateKey, size_t& index) const;
+    bool lookupRate(int dateKey, double& rate) const;
+    bool rangeStats(int fromKey, int toKey, RangeIndex::Stats& stats) const;
+    void processRange(const char* line, const char* end, const char* const* tokens,
+                      const char* const* tokenEnds, OutputBuffer& out) const;
+    void useVectorStorage();
+    size_t advanceRateIndex(size_t position, int dateKey) const;
 
 };
 
@@ -0,0 +1,365 @@
+#include "ExchangeServer.hpp"
+#include "Platform.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+ExchangeServer::ExchangeServer(const std::string& socketPath, const std::string& databaseFile, int workerCount)
+    : _socketPath(socketPath), _databaseFile(databaseFile), _listenFd(-1), _stopping(false),
+      _current(NULL), _spare(NULL), _epoch(1) {
+    if (workerCount < 1) {
+        workerCount = 1;
+    }
+    Worker worker;
+    worker.server = this;
+    worker.epoch = 0;
+    worker.connection = -1;
+    _workers.assign(workerCount, worker);
+
+    _current = new BitcoinExchange(_databaseFile);
+    if (!_current->isLoaded()) {
+        delete _current;
+        _current = NULL;
+        throw ServerException("Database is not loaded or empty.");
+    }
+    _current->prepareRanges();
+}
+
+ExchangeServer::ExchangeServer(const ExchangeServer& other)
+    : _listenFd(-1), _stopping(false), _current(NULL), _spare(NULL), _epoch(1) {
+    (void)other;
+}
+
+ExchangeServer& ExchangeServer::operator=(const ExchangeServer& other) {
+    (void)other;
+    return *this;
+}
+
+ExchangeServer::~ExchangeServer() {
+    if (_listenFd >= 0) {
+        close(_listenFd);
+        unlink(_socketPath.c_str());
+    }
+    delete _current;
+    delete _spare;
+}
+
+void ExchangeServer::openSocket() {
+    struct sockaddr_un address;
+    if (_socketPath.size() >= sizeof(address.sun_path)) {
+        throw ServerException("Socket path is too long.");
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, _socketPath.c_str());
+
+    _listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_listenFd < 0) {
+        throw ServerException("Could not create socket.");
+    }
+    unlink(_socketPath.c_str());
+    if (bind(_listenFd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0
+        || listen(_listenFd, 128) < 0) {
+        close(_listenFd);
+        _listenFd = -1;
+        throw ServerException("Could not listen on " + _socketPath + ": " + std::strerror(errno));
+    }
+}
+
+// --- Reader side ---
+
+// Announces the epoch this worker reads in before loading the table pointer,
+// so a reload that bumps the epoch afterwards knows to wait for it.
+const BitcoinExchange* ExchangeServer::pin(Worker& worker) {
+    worker.epoch = _epoch;
+    __sync_synchronize();
+    return _current;
+}
+
+void ExchangeServer::unpin(Worker& worker) {
+    __sync_synchronize();
+    worker.epoch = 0;
+}
+
+// --- Writer side ---
+
+// Returns once no worker is still reading in an epoch older than `epoch`.
+void ExchangeServer::waitForReaders(unsigned long epoch) {
+    struct timespec pause;
+    pause.tv_sec = 0;
+    pause.tv_nsec = 1000000;
+
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        while (true) {
+            unsigned long seen = _workers[i].epoch;
+            if (seen == 0 || seen >= epoch) break;
+            nanosleep(&pause, NULL);
+        }
+    }
+}
+
+// Brings the spare table up to date with the rows appended since it was
+// last read. Returns NULL, dropping the spare, if there is none or the
+// ingest fails.
+BitcoinExchange* ExchangeServer::catchUp() {
+    BitcoinExchange* fresh = _spare;
+    _spare = NULL;
+    if (fresh == NULL) {
+        return NULL;
+    }
+    try {
+        fresh->ingestAppended();
+        fresh->prepareRanges();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: incremental reload failed: " << e.what() << std::endl;
+        delete fresh;
+        return NULL;
+    }
+    return fresh;
+}
+
+// appended says the file only grew since the last reload, so the spare can
+// catch up and the retired table becomes the next spare. Any other change
+// loads the file from scratch and drops both older tables.
+void ExchangeServer::reload(bool appended) {
+    BitcoinExchange* fresh = appended ? catchUp() : NULL;
+    if (fresh == NULL) {
+        fresh = new BitcoinExchange(_databaseFile);
+        if (!fresh->isLoaded()) {
+            std::cerr << "Error: reload failed, keeping the current rate table." << std::endl;
+            delete fresh;
+            return;
+        }
+        fresh->prepareRanges();
+    }
+
+    BitcoinExchange* old = _current;
+    _current = fresh;
+    __sync_synchronize();
+    unsigned long epoch = __sync_add_and_fetch(&_epoch, 1);
+    waitForReaders(epoch);
+    delete _spare;
+    _spare = NULL;
+    if (appended) {
+        _spare = old;
+    } else {
+        delete old;
+    }
+    std::cerr << "Rate table " << (appended ? "updated" : "reloaded") << " from " << _databaseFile << std::endl;
+}
+
+// appended is set when the file is the same one and only grew.
+bool ExchangeServer::databaseChanged(struct stat& lastSeen, bool& appended) const {
+    struct stat now;
+    if (stat(_databaseFile.c_str(), &now) < 0) {
+        return false;
+    }
+    bool changed = now.st_mtime != lastSeen.st_mtime
+        || STAT_MTIME_NSEC(now) != STAT_MTIME_NSEC(lastSeen)
+        || now.st_size != lastSeen.st_size;
+    appended = now.st_dev == lastSeen.st_dev && now.st_ino == lastSeen.st_ino && now.st_size > lastSeen.st_size;
+    lastSeen = now;
+    return changed;
+}
+
+// --- Workers ---
+
+void* ExchangeServer::workerMain(void* arg) {
+    Worker& worker = *static_cast<Worker*>(arg);
+    ExchangeServer& server = *worker.server;
+
+    while (!server._stopping) {
+        int fd = accept(server._listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        suppressSigpipe(fd);
+        worker.connection = fd;
+        __sync_synchronize();
+        if (server._stopping) {
+            shutdown(fd, SHUT_RDWR);
+        }
+        server.serveConnection(worker, fd);
+        worker.connection = -1;
+        close(fd);
+    }
+    return NULL;
+}
+
+// Answers every complete line received so far with one pinned table, then
+// sends the replies in a single write. A line that does not fit in the
+// buffer is refused and ends the connection; a last line without a newline
+// is answered when the client closes its side, as processInput does.
+void ExchangeServer::serveConnection(Worker& worker, int fd) {
+    static const size_t maxLineLength = 1 << 16;
+
+    std::vector<char> buffer(maxLineLength);
+    OutputBuffer out;
+    size_t used = 0;
+    bool eof = false;
+
+    while (!eof) {
+        if (used == buffer.size()) {
+            out.write(OutputBuffer::ERR, "Error: bad input\n");
+            out.writeTo(fd);
+            break;
+        }
+        ssize_t n = recv(fd, &buffer[used], buffer.size() - used, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) break;
+        if (n == 0) {
+            eof = true;
+        }
+        used += static_cast<size_t>(n);
+
+        const char* p = &buffer[0];
+        const char* end = p + used;
+        const BitcoinExchange* exchange = pin(worker);
+        while (p < end) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!nl) {
+                if (!eof) break;
+                nl = end;
+            }
+            exchange->processLine(p, nl, out);
+            p = nl < end ? nl + 1 : end;
+        }
+        unpin(worker);
+
+        used = static_cast<size_t>(end - p);
+        std::memmove(&buffer[0], p, used);
+        if (!out.empty() && !out.writeTo(fd)) break;
+    }
+}
+
+// --- Control ---
+
+// The control signals are written to this pipe by their handler and read
+// by run(), so they are handled between polls rather than in the handler.
+static int signalPipe[2] = { -1, -1 };
+
+static void onControlSignal(int signal) {
+    int saved = errno;
+    unsigned char byte = static_cast<unsigned char>(signal);
+    ssize_t ignored = write(signalPipe[1], &byte, 1);
+    (void)ignored;
+    errno = saved;
+}
+
+static void handleControlSignals(void (*handler)(int)) {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = handler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGHUP, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+}
+
+void ExchangeServer::stop() {
+    _stopping = true;
+    __sync_synchronize();
+    shutdown(_listenFd, SHUT_RDWR);
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        int fd = _workers[i].connection;
+        if (fd >= 0) {
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+}
+
+void ExchangeServer::run() {
+    openSocket();
+
+    if (pipe(signalPipe) < 0) {
+        throw ServerException("Could not create the signal pipe.");
+    }
+    fcntl(signalPipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(signalPipe[1], F_SETFL, O_NONBLOCK);
+
+    // Workers inherit this mask, so the control signals are only ever
+    // handled on this thread, which unblocks them once the workers run.
+    // SIGPIPE stays blocked everywhere.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    size_t started = 0;
+    for (; started < _workers.size(); ++started) {
+        if (pthread_create(&_workers[started].thread, NULL, &ExchangeServer::workerMain, &_workers[started]) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        close(signalPipe[0]);
+        close(signalPipe[1]);
+        throw ServerException("Could not start worker threads.");
+    }
+    handleControlSignals(&onControlSignal);
+    sigdelset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+    std::cerr << "Listening on " << _socketPath << " with " << started << " workers" << std::endl;
+
+    struct stat lastSeen;
+    std::memset(&lastSeen, 0, sizeof(lastSeen));
+    bool appended;
+    databaseChanged(lastSeen, appended);
+
+    // Wakes for a signal, or once a second to look at the database file.
+    struct pollfd control;
+    control.fd = signalPipe[0];
+    control.events = POLLIN;
+    bool running = true;
+    while (running) {
+        control.revents = 0;
+        if (poll(&control, 1, 1000) <= 0) {
+            if (databaseChanged(lastSeen, appended)) {
+                reload(appended);
+            }
+            continue;
+        }
+        unsigned char received[16];
+        ssize_t n = read(signalPipe[0], received, sizeof(received));
+        bool hangup = false;
+        for (ssize_t i = 0; i < n; ++i) {
+            if (received[i] == SIGINT || received[i] == SIGTERM) {
+                running = false;
+            } else if (received[i] == SIGHUP) {
+                hangup = true;
+            }
+        }
+        if (running && hangup) {
+            reload(false);
+        }
+    }
+
+    handleControlSignals(SIG_DFL);
+    close(signalPipe[0]);
+    close(signalPipe[1]);
+    signalPipe[0] = -1;
+    signalPipe[1] = -1;
+    stop();
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(_workers[i].thread, NULL);
+    }
+}
+
+ExchangeServer::ServerException::ServerException(const std::string& message) : _message(message) {}
+
+ExchangeServer::ServerException::~ServerException() throw() {}
+
+const char* ExchangeServer::ServerException::what() const throw() {
+    return _message.c_str();
+}
@@ -0,0 +1,73 @@
+#ifndef EXCHANGESERVER_HPP
+#define EXCHANGESERVER_HPP
+
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "BitcoinExchange.hpp"
+
+// Long-running query server on a Unix domain socket. Clients send
+// "date | value" lines and get back exactly what processInput would print
+// for them, one line per non-blank request line.
+//
+// The rate table is replaced without blocking readers: workers publish the
+// epoch they are reading in, a reload swaps the table pointer, bumps the
+// epoch and retires the old table once every worker has moved past it.
+// While the database file only grows, the retired table is kept as a spare
+// and the next reload ingests the appended rows into it instead of parsing
+// the whole file again.
+class ExchangeServer {
+public:
+    ExchangeServer(const std::string& socketPath, const std::string& databaseFile, int workerCount);
+    ~ExchangeServer();
+
+    // Serves until SIGINT or SIGTERM. SIGHUP, or a change to the database
+    // file, reloads the rate table.
+    void run();
+
+    class ServerException : public std::exception {
+        private:
+            std::string _message;
+        public:
+            ServerException(const std::string& message);
+            virtual ~ServerException() throw();
+            virtual const char* what() const throw();
+    };
+
+private:
+    struct Worker {
+        ExchangeServer* server;
+        pthread_t thread;
+        volatile unsigned long epoch;
+        volatile int connection;
+    };
+
+    std::string _socketPath;
+    std::string _databaseFile;
+    int _listenFd;
+    volatile bool _stopping;
+    BitcoinExchange* volatile _current;
+    BitcoinExchange* _spare;
+    volatile unsigned long _epoch;
+    std::vector<Worker> _workers;
+
+    ExchangeServer();
+    ExchangeServer(const ExchangeServer& other);
+    ExchangeServer& operator=(const ExchangeServer& other);
+
+    void openSocket();
+    void reload(bool appended);
+    BitcoinExchange* catchUp();
+    void stop();
+    bool databaseChanged(struct stat& lastSeen, bool& appended) const;
+
+    const BitcoinExchange* pin(Worker& worker);
+    void unpin(Worker& worker);
+    void waitForReaders(unsigned long epoch);
+
+    static void* workerMain(void* arg);
+    void serveConnection(Worker& worker, int fd);
+};
+
+#endif
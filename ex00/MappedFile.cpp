@@ -0,0 +1,65 @@
+#include "MappedFile.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : _data(NULL), _size(0) {}
+
+MappedFile::MappedFile(const MappedFile& other) : _data(NULL), _size(0) {
+    (void)other;
+}
+
+MappedFile& MappedFile::operator=(const MappedFile& other) {
+    (void)other;
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    // An empty file cannot be mapped, but it is still a successful open.
+    if (st.st_size > 0) {
+        void* addr = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        _data = static_cast<const char*>(addr);
+        _size = static_cast<size_t>(st.st_size);
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (_data) {
+        munmap(const_cast<char*>(_data), _size);
+    }
+    _data = NULL;
+    _size = 0;
+}
+
+const char* MappedFile::data() const {
+    return _data;
+}
+
+size_t MappedFile::size() const {
+    return _size;
+}
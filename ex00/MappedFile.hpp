@@ -0,0 +1,28 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The mapping is released when the
+// object is destroyed or another file is opened.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data() const;
+    size_t size() const;
+
+private:
+    const char* _data;
+    size_t _size;
+
+    MappedFile(const MappedFile& other);
+    MappedFile& operator=(const MappedFile& other);
+};
+
+#endif
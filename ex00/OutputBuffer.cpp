@@ -0,0 +1,110 @@
+#include "OutputBuffer.hpp"
+#include "Platform.hpp"
+#include <iostream>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <cerrno>
+
+OutputBuffer::OutputBuffer() {}
+
+OutputBuffer::OutputBuffer(const OutputBuffer& other) {
+    (void)other;
+}
+
+OutputBuffer& OutputBuffer::operator=(const OutputBuffer& other) {
+    (void)other;
+    return *this;
+}
+
+OutputBuffer::~OutputBuffer() {}
+
+void OutputBuffer::write(Stream stream, const char* data, size_t length) {
+    _data.append(data, length);
+    if (!_segments.empty() && _segments.back().first == stream) {
+        _segments.back().second = _data.size();
+    } else {
+        _segments.push_back(std::make_pair(stream, _data.size()));
+    }
+}
+
+void OutputBuffer::write(Stream stream, const char* str) {
+    write(stream, str, std::strlen(str));
+}
+
+void OutputBuffer::write(Stream stream, const std::string& str) {
+    write(stream, str.data(), str.size());
+}
+
+size_t OutputBuffer::size() const {
+    return _data.size();
+}
+
+bool OutputBuffer::empty() const {
+    return _data.empty();
+}
+
+void OutputBuffer::clear() {
+    _data.clear();
+    _segments.clear();
+}
+
+// True when stdout and stderr lead to the same file or terminal, in which
+// case their relative order is visible and must be kept.
+static bool streamsShareTarget() {
+    struct stat out;
+    struct stat err;
+    if (fstat(1, &out) < 0 || fstat(2, &err) < 0) {
+        return true;
+    }
+    return out.st_dev == err.st_dev && out.st_ino == err.st_ino;
+}
+
+// With a shared target everything is written through stdout in production
+// order. Otherwise each stream gets a single write of its own segments.
+void OutputBuffer::flush() {
+    static const bool shared = streamsShareTarget();
+
+    if (shared) {
+        std::cout.write(_data.data(), _data.size());
+        std::cout.flush();
+        clear();
+        return;
+    }
+
+    std::string errors;
+    size_t start = 0;
+    for (size_t i = 0; i < _segments.size(); ++i) {
+        size_t end = _segments[i].second;
+        if (_segments[i].first == OUT) {
+            std::cout.write(_data.data() + start, end - start);
+        } else {
+            errors.append(_data, start, end - start);
+        }
+        start = end;
+    }
+    std::cout.flush();
+    if (!errors.empty()) {
+        std::cerr.write(errors.data(), errors.size());
+    }
+    clear();
+}
+
+// Sends both streams, in production order, to a single descriptor such as a
+// socket. Returns false if the descriptor stopped accepting data.
+bool OutputBuffer::writeTo(int fd) {
+    size_t sent = 0;
+    while (sent < _data.size()) {
+        ssize_t n = ::send(fd, _data.data() + sent, _data.size() - sent, SEND_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            clear();
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    clear();
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef OUTPUTBUFFER_HPP
+#define OUTPUTBUFFER_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+// Collects stdout and stderr text in the order it was produced so it can be
+// written out in large blocks while keeping the interleaving of both streams.
+class OutputBuffer {
+public:
+    enum Stream {
+        OUT,
+        ERR
+    };
+
+    OutputBuffer();
+    ~OutputBuffer();
+
+    void write(Stream stream, const char* data, size_t length);
+    void write(Stream stream, const char* str);
+    void write(Stream stream, const std::string& str);
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+    void flush();
+    bool writeTo(int fd);
+
+private:
+    std::string _data;
+    // Each segment is the stream it belongs to and its end offset in _data.
+    std::vector<std::pair<Stream, size_t> > _segments;
+
+    OutputBuffer(const OutputBuffer& other);
+    OutputBuffer& operator=(const OutputBuffer& other);
+};
+
+#endif
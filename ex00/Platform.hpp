@@ -0,0 +1,38 @@
+#ifndef PLATFORM_HPP
+#define PLATFORM_HPP
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+// The nanoseconds of a struct stat's modification time, next to the whole
+// seconds in st_mtime. Linux names the timespec st_mtim and macOS
+// st_mtimespec; elsewhere only the seconds are compared.
+#if defined(__APPLE__)
+# define STAT_MTIME_NSEC(st) (static_cast<long>((st).st_mtimespec.tv_nsec))
+#elif defined(__linux__)
+# define STAT_MTIME_NSEC(st) (static_cast<long>((st).st_mtim.tv_nsec))
+#else
+# define STAT_MTIME_NSEC(st) (static_cast<long>(0))
+#endif
+
+// send() flags that keep a write to a closed peer from raising SIGPIPE.
+// Without MSG_NOSIGNAL the socket is marked by suppressSigpipe instead.
+#if defined(MSG_NOSIGNAL)
+# define SEND_NOSIGNAL MSG_NOSIGNAL
+#else
+# define SEND_NOSIGNAL 0
+#endif
+
+// Marks a socket so that writes to a closed peer fail with EPIPE rather
+// than raise SIGPIPE, where the platform offers SO_NOSIGPIPE (macOS, the
+// BSDs). Elsewhere the caller must block or ignore SIGPIPE.
+inline void suppressSigpipe(int fd) {
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)fd;
+#endif
+}
+
+#endif // PLATFORM_HPP
@@ -0,0 +1,119 @@
+#include "RangeIndex.hpp"
+
+RangeIndex::RangeIndex() : _values(NULL), _count(0), _blocks(0) {}
+
+RangeIndex::RangeIndex(const RangeIndex& other) : _values(NULL), _count(0), _blocks(0) {
+    (void)other;
+}
+
+RangeIndex& RangeIndex::operator=(const RangeIndex& other) {
+    (void)other;
+    return *this;
+}
+
+RangeIndex::~RangeIndex() {}
+
+static size_t floorLog2(size_t n) {
+    size_t log = 0;
+    while (n >>= 1) {
+        ++log;
+    }
+    return log;
+}
+
+void RangeIndex::build(const double* values, size_t count) {
+    _values = values;
+    _count = count;
+    _blocks = (count + blockSize - 1) >> blockShift;
+
+    _prefix.resize(count + 1);
+    _prefix[0] = 0;
+    for (size_t i = 0; i < count; ++i) {
+        _prefix[i + 1] = _prefix[i] + values[i];
+    }
+
+    size_t levels = _blocks ? floorLog2(_blocks) + 1 : 0;
+    _min.resize(levels * _blocks);
+    _max.resize(levels * _blocks);
+    for (size_t b = 0; b < _blocks; ++b) {
+        size_t end = (b + 1) << blockShift;
+        scan(b << blockShift, end < count ? end : count, _min[b], _max[b]);
+    }
+    for (size_t k = 1; k < levels; ++k) {
+        const double* lowPrev = &_min[(k - 1) * _blocks];
+        const double* highPrev = &_max[(k - 1) * _blocks];
+        double* low = &_min[k * _blocks];
+        double* high = &_max[k * _blocks];
+        size_t half = static_cast<size_t>(1) << (k - 1);
+        for (size_t b = 0; b + (half << 1) <= _blocks; ++b) {
+            low[b] = lowPrev[b] < lowPrev[b + half] ? lowPrev[b] : lowPrev[b + half];
+            high[b] = highPrev[b] > highPrev[b + half] ? highPrev[b] : highPrev[b + half];
+        }
+    }
+}
+
+void RangeIndex::clear() {
+    _values = NULL;
+    _count = 0;
+    _blocks = 0;
+    std::vector<long double>().swap(_prefix);
+    std::vector<double>().swap(_min);
+    std::vector<double>().swap(_max);
+}
+
+size_t RangeIndex::size() const {
+    return _count;
+}
+
+void RangeIndex::scan(size_t first, size_t last, double& low, double& high) const {
+    low = _values[first];
+    high = _values[first];
+    for (size_t i = first + 1; i < last; ++i) {
+        if (_values[i] < low) low = _values[i];
+        if (_values[i] > high) high = _values[i];
+    }
+}
+
+// Returns false for an empty window.
+bool RangeIndex::stats(size_t first, size_t last, Stats& result) const {
+    if (last > _count) {
+        last = _count;
+    }
+    if (first >= last) {
+        return false;
+    }
+
+    result.count = last - first;
+    result.sum = static_cast<double>(_prefix[last] - _prefix[first]);
+    result.mean = static_cast<double>((_prefix[last] - _prefix[first]) / static_cast<long double>(result.count));
+
+    // Whole blocks strictly inside the window go through the sparse table;
+    // the ragged ends are scanned directly.
+    size_t firstBlock = (first + blockSize - 1) >> blockShift;
+    size_t lastBlock = last >> blockShift;
+    if (firstBlock >= lastBlock) {
+        scan(first, last, result.min, result.max);
+        return true;
+    }
+
+    size_t k = floorLog2(lastBlock - firstBlock);
+    const double* low = &_min[k * _blocks];
+    const double* high = &_max[k * _blocks];
+    size_t other = lastBlock - (static_cast<size_t>(1) << k);
+    result.min = low[firstBlock] < low[other] ? low[firstBlock] : low[other];
+    result.max = high[firstBlock] > high[other] ? high[firstBlock] : high[other];
+
+    double edgeLow;
+    double edgeHigh;
+    if (first < (firstBlock << blockShift)) {
+        scan(first, firstBlock << blockShift, edgeLow, edgeHigh);
+        if (edgeLow < result.min) result.min = edgeLow;
+        if (edgeHigh > result.max) result.max = edgeHigh;
+    }
+    if ((lastBlock << blockShift) < last) {
+        scan(lastBlock << blockShift, last, edgeLow, edgeHigh);
+        if (edgeLow < result.min) result.min = edgeLow;
+        if (edgeHigh > result.max) result.max = edgeHigh;
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef RANGEINDEX_HPP
+#define RANGEINDEX_HPP
+
+#include <vector>
+#include <cstddef>
+
+// Aggregates over any window [first, last) of a fixed array of values.
+// Sums come from prefix sums; minimum and maximum from a sparse table over
+// blocks of 32 values plus a scan of the two partial blocks at the ends, so
+// a window costs O(1) regardless of its width.
+class RangeIndex {
+public:
+    struct Stats {
+        double min;
+        double max;
+        double sum;
+        double mean;
+        size_t count;
+    };
+
+    RangeIndex();
+    ~RangeIndex();
+
+    // The index keeps a pointer to values; rebuild it if they move.
+    void build(const double* values, size_t count);
+    void clear();
+    size_t size() const;
+    bool stats(size_t first, size_t last, Stats& result) const;
+
+private:
+    static const size_t blockShift = 5;
+    static const size_t blockSize = static_cast<size_t>(1) << blockShift;
+
+    const double* _values;
+    size_t _count;
+    size_t _blocks;
+
+    // Long double keeps the difference of two large prefixes accurate for
+    // narrow windows.
+    std::vector<long double> _prefix;
+
+    // Level k holds, for every block b, the extremes of blocks [b, b + 2^k).
+    std::vector<double> _min;
+    std::vector<double> _max;
+
+    RangeIndex(const RangeIndex& other);
+    RangeIndex& operator=(const RangeIndex& other);
+
+    void scan(size_t first, size_t last, double& low, double& high) const;
+};
+
+#endif
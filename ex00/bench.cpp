@@ -0,0 +1,417 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "BitcoinExchange.hpp"
+
+// Benchmarks for the exchange against the std::map and string code it
+// replaced, which is kept here as the baseline. Every case runs at least
+// minimumRuns times and until minimumNanos have passed and reports its
+// fastest run, which is the least disturbed by the rest of the machine.
+//
+// lookup  getRate on a 100k-row table against std::map find and
+//         upper_bound, 1M random dates.
+// dates   encodeDate and isValidDate against the substr and atoi
+//         validator, 1M random YYYY-MM-DD strings with month and day in
+//         00-99; the two must agree on every one.
+// batch   queryBatch against validating and calling getRate per query,
+//         1M valid queries, random and sorted, on a 1.6k-row and a
+//         1M-row table; the results must match.
+// ingest  ingestAppended after appending one row, past the end of the
+//         table and inside it (the delta), against a full load, on
+//         2.9M rows: all of 1800-01-01 to 9739, about as many as
+//         YYYY-MM-DD dates allow. Each append is timed once, so the
+//         best and the median of 200 are shown.
+//
+// ./btc_bench [section...]
+
+static const long long minimumNanos = 200000000;
+static const size_t minimumRuns = 5;
+static const char* const benchDatabase = "bench_rates.csv";
+
+static long long nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Keeps results alive so the compiler cannot drop the work.
+static volatile double sink = 0;
+
+// The fastest of the runs of task(), in ns.
+template <typename Task>
+static long long fastest(Task& task) {
+    long long elapsed = 0;
+    long long best = 0;
+    size_t runs = 0;
+    while (runs < minimumRuns || elapsed < minimumNanos) {
+        long long start = nowNanos();
+        task();
+        long long run = nowNanos() - start;
+        elapsed += run;
+        if (runs++ == 0 || run < best) best = run;
+    }
+    return best;
+}
+
+static std::string formatDate(int dateKey) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d", dateKey / 10000, dateKey / 100 % 100, dateKey % 100);
+    return text;
+}
+
+// One row per calendar day from 1800-01-01, written as data.csv is.
+static std::vector<std::string> writeDatabase(size_t rows) {
+    std::vector<std::string> dates;
+    std::ofstream out(benchDatabase);
+    out << "date,exchange_rate\n";
+    for (int key = 18000101; dates.size() < rows; ++key) {
+        if (!BitcoinExchange::isValidDate(key)) continue;
+        dates.push_back(formatDate(key));
+        out << dates.back() << ',' << (std::rand() % 100000) / 100.0 << '\n';
+    }
+    return dates;
+}
+
+// --- lookup ---
+
+typedef std::map<std::string, double> RateMap;
+
+static double mapRate(const RateMap& rates, const std::string& date) {
+    RateMap::const_iterator it = rates.find(date);
+    if (it != rates.end()) {
+        return it->second;
+    }
+    it = rates.upper_bound(date);
+    if (it == rates.begin()) {
+        throw std::runtime_error("No data available for or prior to this date.");
+    }
+    --it;
+    return it->second;
+}
+
+struct MapLookups {
+    const RateMap* rates;
+    const std::vector<std::string>* queries;
+
+    void operator()() {
+        double sum = 0;
+        for (size_t i = 0; i < queries->size(); ++i) {
+            sum += mapRate(*rates, (*queries)[i]);
+        }
+        sink = sink + sum;
+    }
+};
+
+struct FlatLookups {
+    const BitcoinExchange* exchange;
+    const std::vector<std::string>* queries;
+
+    void operator()() {
+        double sum = 0;
+        for (size_t i = 0; i < queries->size(); ++i) {
+            sum += exchange->getRate((*queries)[i]);
+        }
+        sink = sink + sum;
+    }
+};
+
+static void benchLookup() {
+    static const size_t rows = 100000;
+    static const size_t queryCount = 1000000;
+    std::srand(42);
+    std::vector<std::string> dates = writeDatabase(rows);
+    BitcoinExchange exchange(benchDatabase);
+    std::remove(benchDatabase);
+
+    RateMap rates;
+    for (size_t i = 0; i < dates.size(); ++i) {
+        rates[dates[i]] = exchange.getRate(dates[i]);
+    }
+    // Random calendar days after the first row, half of them not in the
+    // table, which takes the upper_bound path in the map.
+    std::vector<std::string> queries;
+    int firstYear = 1800;
+    int years = static_cast<int>(rows / 366);
+    while (queries.size() < queryCount) {
+        int key = (firstYear + std::rand() % years) * 10000 + (1 + std::rand() % 12) * 100 + 1 + std::rand() % 31;
+        if (BitcoinExchange::isValidDate(key)) queries.push_back(formatDate(key));
+    }
+
+    MapLookups map;
+    map.rates = &rates;
+    map.queries = &queries;
+    FlatLookups flat;
+    flat.exchange = &exchange;
+    flat.queries = &queries;
+    std::printf("Rate lookups, %lu-row table, ns/lookup\n", static_cast<unsigned long>(rows));
+    std::printf("%-30s %10.1f\n", "std::map find + upper_bound", static_cast<double>(fastest(map)) / queryCount);
+    std::printf("%-30s %10.1f\n", "getRate (flat arrays)", static_cast<double>(fastest(flat)) / queryCount);
+    std::printf("\n");
+}
+
+// --- dates ---
+
+static bool stringDateValid(const std::string& dateStr) {
+    if (dateStr.length() != 10) return false;
+    if (dateStr[4] != '-' || dateStr[7] != '-') return false;
+
+    for (int i = 0; i < 10; ++i) {
+        if (i == 4 || i == 7) continue;
+        if (!std::isdigit(dateStr[i])) return false;
+    }
+
+    int year = std::atoi(dateStr.substr(0, 4).c_str());
+    int month = std::atoi(dateStr.substr(5, 2).c_str());
+    int day = std::atoi(dateStr.substr(8, 2).c_str());
+
+    if (year < 0) return false;
+    if (month < 1 || month > 12) return false;
+    if (day < 1 || day > 31) return false;
+
+    if ((month == 4 || month == 6 || month == 9 || month == 11) && day > 30) {
+        return false;
+    }
+    if (month == 2) {
+        bool isLeap = (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+        if (isLeap && day > 29) {
+            return false;
+        }
+        if (!isLeap && day > 28) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool packedDateValid(const std::string& dateStr) {
+    int dateKey = BitcoinExchange::encodeDate(dateStr);
+    return dateKey >= 0 && BitcoinExchange::isValidDate(dateKey);
+}
+
+struct ValidateDates {
+    bool (*valid)(const std::string&);
+    const std::vector<std::string>* dates;
+
+    void operator()() {
+        size_t count = 0;
+        for (size_t i = 0; i < dates->size(); ++i) {
+            count += valid((*dates)[i]);
+        }
+        sink = sink + count;
+    }
+};
+
+static void benchDates() {
+    static const size_t dateCount = 1000000;
+    std::srand(42);
+    std::vector<std::string> dates;
+    for (size_t i = 0; i < dateCount; ++i) {
+        char text[16];
+        std::snprintf(text, sizeof(text), "%04d-%02d-%02d", std::rand() % 10000, std::rand() % 100, std::rand() % 100);
+        dates.push_back(text);
+    }
+    size_t mismatches = 0;
+    for (size_t i = 0; i < dates.size(); ++i) {
+        mismatches += stringDateValid(dates[i]) != packedDateValid(dates[i]);
+    }
+
+    ValidateDates task;
+    task.dates = &dates;
+    task.valid = &stringDateValid;
+    double before = static_cast<double>(fastest(task)) / dateCount;
+    task.valid = &packedDateValid;
+    double after = static_cast<double>(fastest(task)) / dateCount;
+    std::printf("Date validation, ns/date (%lu mismatches)\n", static_cast<unsigned long>(mismatches));
+    std::printf("%-30s %10.1f\n", "substr + atoi", before);
+    std::printf("%-30s %10.1f\n", "encodeDate + isValidDate", after);
+    std::printf("\n");
+}
+
+// --- batch ---
+
+typedef std::vector<BitcoinExchange::Query> Queries;
+typedef std::vector<BitcoinExchange::QueryResult> QueryResults;
+
+// What processInput does for each line, minus the parsing and output.
+static void queryEach(const BitcoinExchange& exchange, const Queries& queries, QueryResults& results) {
+    results.resize(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const BitcoinExchange::Query& query = queries[i];
+        BitcoinExchange::QueryResult& result = results[i];
+        result.value = 0;
+        int dateKey = BitcoinExchange::encodeDate(query.date);
+        if (dateKey < 0 || !BitcoinExchange::isValidDate(dateKey)) {
+            result.status = BitcoinExchange::QUERY_BAD_DATE;
+        } else if (query.amount < 0) {
+            result.status = BitcoinExchange::QUERY_NEGATIVE_VALUE;
+        } else if (query.amount > 1000) {
+            result.status = BitcoinExchange::QUERY_TOO_LARGE_VALUE;
+        } else {
+            try {
+                result.value = query.amount * exchange.getRate(query.date);
+                result.status = BitcoinExchange::QUERY_OK;
+            } catch (const std::runtime_error& e) {
+                result.status = BitcoinExchange::QUERY_NO_RATE;
+            }
+        }
+    }
+}
+
+struct EachQuery {
+    const BitcoinExchange* exchange;
+    const Queries* queries;
+    QueryResults results;
+
+    void operator()() {
+        queryEach(*exchange, *queries, results);
+        sink = sink + results[results.size() / 2].value;
+    }
+};
+
+struct BatchQuery {
+    const BitcoinExchange* exchange;
+    const Queries* queries;
+    QueryResults results;
+
+    void operator()() {
+        exchange->queryBatch(*queries, results);
+        sink = sink + results[results.size() / 2].value;
+    }
+};
+
+static bool sameResults(const QueryResults& a, const QueryResults& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].status != b[i].status || a[i].value != b[i].value) return false;
+    }
+    return true;
+}
+
+static bool queryDateLess(const BitcoinExchange::Query& a, const BitcoinExchange::Query& b) {
+    return a.date < b.date;
+}
+
+static void benchBatch() {
+    static const size_t tableSizes[] = { 1600, 1000000 };
+    static const size_t queryCount = 1000000;
+    std::printf("Batch queries, ns/query\n");
+    std::printf("%9s %-8s %14s %14s %8s\n", "rows", "queries", "per query", "queryBatch", "match");
+    for (size_t t = 0; t < 2; ++t) {
+        std::srand(42);
+        std::vector<std::string> dates = writeDatabase(tableSizes[t]);
+        BitcoinExchange exchange(benchDatabase);
+        std::remove(benchDatabase);
+
+        // Valid queries within the table: getRate throws on a date before
+        // the first row, which would swamp the per-query times.
+        int years = static_cast<int>(tableSizes[t] / 366);
+        Queries queries;
+        while (queries.size() < queryCount) {
+            BitcoinExchange::Query query;
+            query.date = formatDate((1800 + std::rand() % years) * 10000 + (1 + std::rand() % 12) * 100
+                                    + 1 + std::rand() % 28);
+            query.amount = (std::rand() % 100000) / 100.0;
+            queries.push_back(query);
+        }
+        for (int sorted = 0; sorted < 2; ++sorted) {
+            if (sorted) std::sort(queries.begin(), queries.end(), queryDateLess);
+            EachQuery each;
+            each.exchange = &exchange;
+            each.queries = &queries;
+            BatchQuery batch;
+            batch.exchange = &exchange;
+            batch.queries = &queries;
+            double eachNanos = static_cast<double>(fastest(each)) / queryCount;
+            double batchNanos = static_cast<double>(fastest(batch)) / queryCount;
+            std::printf("%9lu %-8s %14.1f %14.1f %8s\n", static_cast<unsigned long>(tableSizes[t]),
+                        sorted ? "sorted" : "random", eachNanos, batchNanos,
+                        sameResults(each.results, batch.results) ? "yes" : "NO");
+        }
+    }
+    std::printf("\n");
+}
+
+// --- ingest ---
+
+struct LoadTable {
+    void operator()() {
+        BitcoinExchange exchange(benchDatabase);
+        sink = sink + static_cast<double>(exchange.isLoaded());
+    }
+};
+
+// Appends one row per date and times each ingestAppended, in ns.
+static std::vector<long long> timeAppends(BitcoinExchange& exchange, const std::vector<std::string>& dates) {
+    std::vector<long long> times;
+    for (size_t i = 0; i < dates.size(); ++i) {
+        std::FILE* file = std::fopen(benchDatabase, "a");
+        std::fprintf(file, "%s,%d.5\n", dates[i].c_str(), std::rand() % 100000);
+        std::fclose(file);
+        long long start = nowNanos();
+        size_t ingested = exchange.ingestAppended();
+        times.push_back(nowNanos() - start);
+        sink = sink + static_cast<double>(ingested);
+    }
+    std::sort(times.begin(), times.end());
+    return times;
+}
+
+static void benchIngest() {
+    static const size_t rows = 2900000;
+    static const size_t appends = 200;
+    std::printf("One-row appends on a %lu-row table, us\n", static_cast<unsigned long>(rows));
+    std::printf("%-22s %12s %12s\n", "case", "best", "median");
+
+    std::srand(42);
+    std::vector<std::string> dates = writeDatabase(rows);
+    LoadTable load;
+    double loadMicros = fastest(load) / 1000.0;
+
+    BitcoinExchange exchange(benchDatabase);
+    std::vector<std::string> after;
+    for (int key = 99000101; after.size() < appends; ++key) {
+        if (BitcoinExchange::isValidDate(key)) after.push_back(formatDate(key));
+    }
+    std::vector<std::string> inside;
+    for (size_t i = 0; i < appends; ++i) {
+        inside.push_back(dates[std::rand() % dates.size()]);
+    }
+    std::vector<long long> tail = timeAppends(exchange, after);
+    std::vector<long long> delta = timeAppends(exchange, inside);
+    std::remove(benchDatabase);
+
+    std::printf("%-22s %12.1f %12.1f\n", "past the end", tail[0] / 1000.0, tail[appends / 2] / 1000.0);
+    std::printf("%-22s %12.1f %12.1f\n", "inside (delta)", delta[0] / 1000.0, delta[appends / 2] / 1000.0);
+    std::printf("%-22s %12.1f %12s\n", "full load", loadMicros, "-");
+    std::printf("\n");
+}
+
+struct Section {
+    const char* name;
+    void (*run)();
+};
+
+static const Section sections[] = {
+    { "lookup", &benchLookup },
+    { "dates", &benchDates },
+    { "batch", &benchBatch },
+    { "ingest", &benchIngest },
+    { NULL, NULL }
+};
+
+int main(int argc, char** argv) {
+    for (size_t s = 0; sections[s].name; ++s) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == sections[s].name) selected = true;
+        }
+        if (selected) sections[s].run();
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Platform.hpp"
+
+// Load generator for `btc --serve`: replays the lines of an input file over
+// one or more connections, one request in flight per connection, and reports
+// the latency distribution.
+
+struct Client {
+    const char* socketPath;
+    const std::vector<std::string>* lines;
+    long requests;
+    long offset;
+    std::vector<long long> latencies;
+    bool failed;
+};
+
+static long long nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static int connectTo(const char* socketPath) {
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, SEND_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool readLine(int fd, std::string& pending) {
+    char buffer[4096];
+    while (pending.find('\n') == std::string::npos) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        pending.append(buffer, static_cast<size_t>(n));
+    }
+    pending.erase(0, pending.find('\n') + 1);
+    return true;
+}
+
+static void* runClient(void* arg) {
+    Client& client = *static_cast<Client*>(arg);
+    const std::vector<std::string>& lines = *client.lines;
+
+    int fd = connectTo(client.socketPath);
+    if (fd < 0) {
+        client.failed = true;
+        return NULL;
+    }
+    std::string pending;
+    client.latencies.reserve(client.requests);
+    for (long i = 0; i < client.requests; ++i) {
+        const std::string& line = lines[(client.offset + i) % lines.size()];
+        long long start = nowNanos();
+        if (!sendAll(fd, line) || !readLine(fd, pending)) {
+            client.failed = true;
+            break;
+        }
+        client.latencies.push_back(nowNanos() - start);
+    }
+    close(fd);
+    return NULL;
+}
+
+static double percentile(const std::vector<long long>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted[index] / 1000.0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4 || argc > 5) {
+        std::cerr << "Usage: ./btc_loadgen <socket_path> <input_file> <requests> [connections]" << std::endl;
+        return 1;
+    }
+    // A server that drops a connection must not end the run; without
+    // MSG_NOSIGNAL, send() would raise SIGPIPE.
+    std::signal(SIGPIPE, SIG_IGN);
+    long requests = std::atol(argv[3]);
+    int connections = argc == 5 ? std::atoi(argv[4]) : 1;
+    if (requests < 1 || connections < 1) {
+        std::cerr << "Error: requests and connections must be positive." << std::endl;
+        return 1;
+    }
+
+    // Blank lines get no reply, so they cannot be used as requests.
+    std::ifstream input(argv[2]);
+    if (!input.is_open()) {
+        std::cerr << "Error: could not open file." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    std::getline(input, line);
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            lines.push_back(line + "\n");
+        }
+    }
+    if (lines.empty()) {
+        std::cerr << "Error: no request lines in input file." << std::endl;
+        return 1;
+    }
+
+    std::vector<Client> clients(connections);
+    std::vector<pthread_t> threads(connections);
+    for (int i = 0; i < connections; ++i) {
+        clients[i].socketPath = argv[1];
+        clients[i].lines = &lines;
+        clients[i].requests = requests / connections + (i < requests % connections ? 1 : 0);
+        clients[i].offset = i * 7919L;
+        clients[i].failed = false;
+    }
+
+    long long start = nowNanos();
+    for (int i = 0; i < connections; ++i) {
+        pthread_create(&threads[i], NULL, runClient, &clients[i]);
+    }
+    std::vector<long long> latencies;
+    bool failed = false;
+    for (int i = 0; i < connections; ++i) {
+        pthread_join(threads[i], NULL);
+        failed = failed || clients[i].failed;
+        latencies.insert(latencies.end(), clients[i].latencies.begin(), clients[i].latencies.end());
+    }
+    double seconds = (nowNanos() - start) / 1e9;
+
+    if (failed) {
+        std::cerr << "Error: connection to server failed." << std::endl;
+    }
+    if (latencies.empty()) {
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "requests: " << latencies.size() << " over " << connections << " connection(s)" << std::endl;
+    std::cout << "throughput: " << latencies.size() / seconds << " req/s" << std::endl;
+    std::cout << "latency p50: " << percentile(latencies, 0.50) << " us" << std::endl;
+    std::cout << "latency p99: " << percentile(latencies, 0.99) << " us" << std::endl;
+    std::cout << "latency max: " << latencies.back() / 1000.0 << " us" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -1,18 +1,98 @@
 #include "BitcoinExchange.hpp"
+#include "ExchangeServer.hpp"
 #include <iostream>
 #include <string>
+#include <cstdlib>
+
+static void printUsage() {
+    std::cerr << "Usage: ./btc [--stats] [-j threads] <input_file>" << std::endl;
+    std::cerr << "       ./btc --snapshot <snapshot_file>" << std::endl;
+    std::cerr << "       ./btc --serve <socket_path> [-j workers]" << std::endl;
+}
+
+// Converts data.csv into a binary snapshot that later runs load instead.
+static int writeSnapshot(const std::string& snapshotFile) {
+    try {
+        BitcoinExchange btcExchange;
+        btcExchange.writeSnapshot(snapshotFile);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static bool parseThreadCount(const char* text, int& threadCount) {
+    char* endPtr;
+    long value = std::strtol(text, &endPtr, 10);
+    if (*endPtr != '\0' || endPtr == text || value < 1 || value > 1024) {
+        std::cerr << "Error: invalid thread count." << std::endl;
+        printUsage();
+        return false;
+    }
+    threadCount = static_cast<int>(value);
+    return true;
+}
+
+// Answers "date | value" lines on a Unix socket until interrupted.
+static int serve(int argc, char **argv) {
+    int workerCount = 4;
+    if (argc == 5 && std::string(argv[3]) == "-j") {
+        if (!parseThreadCount(argv[4], workerCount)) return 1;
+    } else if (argc != 3) {
+        printUsage();
+        return 1;
+    }
+
+    try {
+        ExchangeServer server(argv[2], "data.csv", workerCount);
+        server.run();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char **argv) {
-    if (argc != 2) {
+    if (argc == 3 && std::string(argv[1]) == "--snapshot") {
+        return writeSnapshot(argv[2]);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--serve") {
+        return serve(argc, argv);
+    }
+
+    bool showStats = false;
+    int threadCount = 1;
+
+    int i = 1;
+    for (; i < argc - 1; ++i) {
+        std::string option = argv[i];
+        if (option == "--stats") {
+            showStats = true;
+        } else if (option == "-j" && i + 1 < argc - 1) {
+            if (!parseThreadCount(argv[++i], threadCount)) return 1;
+        } else {
+            break;
+        }
+    }
+    if (argc < 2 || i != argc - 1) {
         std::cerr << "Error: could not open file." << std::endl;
         return 1;
     }
 
-    std::string inputFilename = argv[1];
+    std::string inputFilename = argv[i];
 
     try {
         BitcoinExchange btcExchange;
-        btcExchange.processInput(inputFilename);
+        if (threadCount > 1) {
+            btcExchange.processInputParallel(inputFilename, threadCount);
+        } else {
+            btcExchange.processInput(inputFilename);
+        }
+        if (showStats) {
+            btcExchange.printLoadStats();
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
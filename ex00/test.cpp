@@ -0,0 +1,386 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "BitcoinExchange.hpp"
+
+// Regression tests for the exchange; make test builds and runs them. Each
+// check prints what failed, and the exit status is the number of failures.
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+static const char* const databaseFile = "test_rates.csv";
+
+static void writeFile(const std::string& filename, const std::string& text, bool append) {
+    std::ofstream out(filename.c_str(), append ? std::ios::app : std::ios::trunc);
+    out << text;
+}
+
+// What processLine prints for each line of input, both streams in order.
+static std::string answer(const BitcoinExchange& exchange, const std::string& input) {
+    OutputBuffer out;
+    const char* p = input.data();
+    const char* end = p + input.size();
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!nl) nl = end;
+        exchange.processLine(p, nl, out);
+        p = nl + 1;
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        return "";
+    }
+    out.writeTo(fds[0]);
+    close(fds[0]);
+    std::string text;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fds[1], buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, static_cast<size_t>(n));
+    }
+    close(fds[1]);
+    return text;
+}
+
+// Rows appended after the load, in and out of date order, must answer
+// exactly as a fresh load of the grown file does.
+static void testIngestAppended() {
+    std::remove(BitcoinExchange::snapshotPath(databaseFile).c_str());
+    writeFile(databaseFile, "date,exchange_rate\n2020-01-01,10\n2020-01-10,20\n", false);
+    BitcoinExchange exchange(databaseFile);
+    check(exchange.isLoaded(), "initial load");
+
+    const std::string queries =
+        "2019-12-31 | 1\n2020-01-05 | 1\n2020-01-10 | 2\n2020-01-15 | 1\n2020-02-01 | 1\n"
+        "2020-01-01 .. 2020-02-01\n";
+    check(answer(exchange, "2020-01-15 | 1\n") == "2020-01-15 => 1 = 20\n", "before the append");
+
+    writeFile(databaseFile, "2020-01-15,30\n2020-01-05,15\n2020-01-10,25\n2020-02-0", true);
+    check(exchange.ingestAppended() == 3, "three complete rows taken in");
+    writeFile(databaseFile, "1,40\n", true);
+    check(exchange.ingestAppended() == 1, "the partial row once it is complete");
+
+    BitcoinExchange reloaded(databaseFile);
+    std::string expected = answer(reloaded, queries);
+    check(answer(exchange, queries) == expected, "ingested table answers like a full load");
+    check(answer(exchange, "2020-01-05 | 2\n") == "2020-01-05 => 2 = 30\n", "out-of-order row overrides");
+    exchange.prepareRanges();
+    check(answer(exchange, queries) == expected, "after merging the delta");
+    std::remove(databaseFile);
+}
+
+// The number as processLine prints it, which is how std::ostream does.
+static std::string formatNumber(double value) {
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+// The line processLine prints for a query, built from a queryBatch result.
+static std::string describe(const BitcoinExchange::Query& query, const BitcoinExchange::QueryResult& result) {
+    switch (result.status) {
+        case BitcoinExchange::QUERY_OK:
+            return query.date + " => " + formatNumber(query.amount) + " = " + formatNumber(result.value) + "\n";
+        case BitcoinExchange::QUERY_BAD_DATE:
+            return "Error: bad input => " + query.date + "\n";
+        case BitcoinExchange::QUERY_NEGATIVE_VALUE:
+            return "Error: not a positive number.\n";
+        case BitcoinExchange::QUERY_TOO_LARGE_VALUE:
+            return "Error: too large a number.\n";
+        default:
+            return "Error: No data available for or prior to this date. (for date: " + query.date + ")\n";
+    }
+}
+
+// queryBatch must answer every query as processLine answers its line.
+static void checkBatch(const BitcoinExchange& exchange, const std::vector<std::string>& dates,
+                       const std::vector<std::string>& amounts, const std::string& what) {
+    std::vector<BitcoinExchange::Query> queries;
+    for (size_t i = 0; i < dates.size(); ++i) {
+        BitcoinExchange::Query query;
+        query.date = dates[i];
+        query.amount = std::strtod(amounts[i % amounts.size()].c_str(), NULL);
+        queries.push_back(query);
+    }
+    std::vector<BitcoinExchange::QueryResult> results;
+    exchange.queryBatch(queries, results);
+    check(results.size() == queries.size(), what + ": one result per query");
+    for (size_t i = 0; i < queries.size() && i < results.size(); ++i) {
+        std::string line = dates[i] + " | " + amounts[i % amounts.size()] + "\n";
+        check(describe(queries[i], results[i]) == answer(exchange, line), what + ": " + line);
+    }
+}
+
+static void testQueryBatch() {
+    writeFile(databaseFile, "date,exchange_rate\n2011-01-03,0.3\n2011-01-05,0.5\n2011-01-05,0.25\n"
+              "2011-02-01,1.5\n2012-02-29,4\n", false);
+    BitcoinExchange exchange(databaseFile);
+    std::remove(databaseFile);
+
+    const char* const dateList[] = {
+        "2010-12-31", "2011-01-03", "2011-01-04", "2011-01-05", "2011-01-31", "2011-02-01", "2012-02-28",
+        "2012-02-29", "2030-01-01", "2011-02-30", "2011-13-01", "2011-1-01", "2012-02-29", NULL
+    };
+    const char* const amountList[] = { "1", "0.5", "3", "10.25", "-1", "1000", "1001", "0", NULL };
+    std::vector<std::string> dates(dateList, dateList + 13);
+    std::vector<std::string> amounts(amountList, amountList + 8);
+    checkBatch(exchange, dates, amounts, "unsorted batch");
+    std::vector<std::string> sorted(dates);
+    std::sort(sorted.begin(), sorted.end());
+    checkBatch(exchange, sorted, amounts, "sorted batch");
+    checkBatch(exchange, std::vector<std::string>(), amounts, "empty batch");
+
+    // A table too large for the per-query path merges unsorted queries
+    // through a sorted index.
+    std::string rows = "date,exchange_rate\n";
+    std::vector<std::string> many;
+    for (int year = 1950; year < 2010; ++year) {
+        for (int month = 1; month <= 12; ++month) {
+            for (int day = 1; day <= 28; ++day) {
+                char date[16];
+                std::snprintf(date, sizeof(date), "%04d-%02d-%02d", year, month, day);
+                if (day % 3 != 0) rows += std::string(date) + "," + formatNumber(day * 0.5 + month) + "\n";
+                if (day % 7 == 0) many.push_back(date);
+            }
+        }
+    }
+    writeFile(databaseFile, rows, false);
+    BitcoinExchange large(databaseFile);
+    std::remove(databaseFile);
+    many.push_back("1949-12-31");
+    many.push_back("2011-02-30");
+    std::srand(7);
+    for (size_t i = many.size(); i > 1; --i) {
+        std::swap(many[i - 1], many[std::rand() % i]);
+    }
+    checkBatch(large, many, amounts, "unsorted batch on a large table");
+}
+
+static bool isBadDate(const std::string& date) {
+    int key = BitcoinExchange::encodeDate(date);
+    return key < 0 || !BitcoinExchange::isValidDate(key);
+}
+
+// The line processLine prints for a range, built from queryRange.
+static std::string describeRange(BitcoinExchange& exchange, const std::string& from, const std::string& to) {
+    RangeIndex::Stats stats;
+    try {
+        if (!exchange.queryRange(from, to, stats)) {
+            return "Error: No data available in this range. (for range: " + from + " .. " + to + ")\n";
+        }
+    } catch (const BitcoinExchange::InvalidDateException&) {
+        return "Error: bad input => " + (isBadDate(from) ? from : to) + "\n";
+    } catch (const BitcoinExchange::BadInputException&) {
+        return "Error: bad input => " + from + " .. " + to + "\n";
+    }
+    return from + " .. " + to + " => min = " + formatNumber(stats.min) + ", max = " + formatNumber(stats.max) +
+           ", mean = " + formatNumber(stats.mean) + ", sum = " + formatNumber(stats.sum) +
+           ", count = " + formatNumber(static_cast<double>(stats.count)) + "\n";
+}
+
+static void testQueryRange() {
+    std::remove(BitcoinExchange::snapshotPath(databaseFile).c_str());
+    writeFile(databaseFile, "date,exchange_rate\n2011-01-03,0.5\n2011-01-05,2\n2011-02-01,1.5\n"
+              "2012-02-29,4\n", false);
+    BitcoinExchange exchange(databaseFile);
+
+    const char* const ranges[][2] = {
+        { "2011-01-03", "2012-02-29" }, { "2011-01-04", "2011-01-31" }, { "2011-01-05", "2011-01-05" },
+        { "2000-01-01", "2030-12-31" }, { "2000-01-01", "2011-01-02" }, { "2011-01-06", "2011-01-31" },
+        { "2013-01-01", "2013-12-31" }, { "2011-02-01", "2011-01-03" }, { "2011-02-30", "2011-03-01" },
+        { "2011-01-01", "2011-13-01" }, { NULL, NULL }
+    };
+    for (size_t i = 0; ranges[i][0]; ++i) {
+        std::string line = std::string(ranges[i][0]) + " .. " + ranges[i][1] + "\n";
+        check(describeRange(exchange, ranges[i][0], ranges[i][1]) == answer(exchange, line), "range " + line);
+    }
+
+    RangeIndex::Stats stats;
+    check(exchange.queryRange("2011-01-01", "2011-12-31", stats) && stats.count == 3 && stats.min == 0.5 &&
+          stats.max == 2 && stats.sum == 4, "aggregates of the rows in the range");
+    check(!exchange.queryRange("2010-01-01", "2011-01-02", stats), "range before the first row is empty");
+
+    // Rows taken in since the last prepareRanges are answered by a scan in
+    // processLine and by the rebuilt index in queryRange.
+    writeFile(databaseFile, "2011-01-04,8\n2011-01-05,0.25\n", true);
+    check(exchange.ingestAppended() == 2, "rows appended for the range check");
+    std::string line = "2011-01-01 .. 2011-01-31\n";
+    std::string scanned = answer(exchange, line);
+    check(describeRange(exchange, "2011-01-01", "2011-01-31") == scanned, "range after an ingest");
+    check(scanned == "2011-01-01 .. 2011-01-31 => min = 0.25, max = 8, mean = 2.91667, sum = 8.75, count = 3\n",
+          "appended rows replace and join the range");
+    std::remove(databaseFile);
+}
+
+// Dates the CSV an hour back, so that a snapshot written now is fresh.
+static void ageDatabase() {
+    struct timeval times[2];
+    gettimeofday(&times[0], NULL);
+    times[0].tv_sec -= 3600;
+    times[1] = times[0];
+    utimes(databaseFile, times);
+}
+
+// Loads the exchange with its warnings silenced and answers the queries.
+static std::string loadAndAnswer(const std::string& queries) {
+    std::streambuf* errors = std::cerr.rdbuf();
+    std::ostringstream ignored;
+    std::cerr.rdbuf(ignored.rdbuf());
+    BitcoinExchange exchange(databaseFile);
+    std::cerr.rdbuf(errors);
+    return answer(exchange, queries);
+}
+
+static void corruptSnapshot(long offset) {
+    std::FILE* file = std::fopen(BitcoinExchange::snapshotPath(databaseFile).c_str(), "r+b");
+    if (!file) return;
+    std::fseek(file, offset, offset < 0 ? SEEK_END : SEEK_SET);
+    int byte = std::fgetc(file);
+    std::fseek(file, -1, SEEK_CUR);
+    std::fputc(byte ^ 0x40, file);
+    std::fclose(file);
+}
+
+// A fresh snapshot answers as the CSV it was written from. The CSV is then
+// replaced behind it with other rates, so each answer shows which one was
+// read: a stale, corrupt or truncated snapshot must fall back to the CSV.
+static void testSnapshot() {
+    const std::string snapshotFile = BitcoinExchange::snapshotPath(databaseFile);
+    const std::string queries = "2011-01-03 | 2\n2011-02-15 | 1\n2010-12-31 | 1\n2011-01-01 .. 2011-12-31\n";
+    const std::string original = "date,exchange_rate\n2011-01-03,0.3\n2011-02-01,1.5\n2011-06-01,4\n";
+    const std::string replaced = "date,exchange_rate\n2011-01-03,0.7\n2011-02-01,2.5\n2011-06-01,8\n";
+
+    std::remove(snapshotFile.c_str());
+    writeFile(databaseFile, original, false);
+    std::string expected;
+    {
+        BitcoinExchange exchange(databaseFile);
+        expected = answer(exchange, queries);
+        exchange.writeSnapshot(snapshotFile);
+    }
+    check(access((snapshotFile + ".tmp").c_str(), F_OK) != 0, "no temporary file left behind");
+    check(loadAndAnswer(queries) == expected, "snapshot answers as the CSV");
+
+    writeFile(databaseFile, replaced, false);
+    std::string fromReplaced = loadAndAnswer(queries);
+    check(fromReplaced != expected, "the replaced CSV answers differently");
+    ageDatabase();
+    check(loadAndAnswer(queries) == expected, "a fresh snapshot is preferred");
+
+    corruptSnapshot(-3);
+    check(loadAndAnswer(queries) == fromReplaced, "corrupt rate falls back to the CSV");
+    corruptSnapshot(-3);
+    corruptSnapshot(26);
+    check(loadAndAnswer(queries) == fromReplaced, "corrupt date falls back to the CSV");
+    corruptSnapshot(26);
+    check(loadAndAnswer(queries) == expected, "restored snapshot is read again");
+
+    writeFile(databaseFile, replaced, false);
+    check(loadAndAnswer(queries) == fromReplaced, "stale snapshot falls back to the CSV");
+
+    ageDatabase();
+    truncate(snapshotFile.c_str(), 40);
+    check(loadAndAnswer(queries) == fromReplaced, "truncated snapshot falls back to the CSV");
+
+    std::remove(snapshotFile.c_str());
+    std::remove(databaseFile);
+}
+
+// Everything processInput (threads 0) or processInputParallel writes to
+// stdout and stderr, captured through one file so the order is kept.
+static std::string captureProcessing(BitcoinExchange& exchange, const char* inputFile, int threads) {
+    static const char* const captureFile = "test_output.txt";
+    std::cout.flush();
+    std::cerr.flush();
+    int savedOut = dup(1);
+    int savedErr = dup(2);
+    int fd = open(captureFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    dup2(fd, 1);
+    dup2(fd, 2);
+    close(fd);
+    if (threads == 0) {
+        exchange.processInput(inputFile);
+    } else {
+        exchange.processInputParallel(inputFile, threads);
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    dup2(savedOut, 1);
+    dup2(savedErr, 2);
+    close(savedOut);
+    close(savedErr);
+
+    std::ifstream in(captureFile, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    in.close();
+    std::remove(captureFile);
+    return text.str();
+}
+
+// The parallel mode must print exactly what the serial one does, on an
+// input small enough for one chunk and on one spanning several, with
+// every kind of bad line and no newline at the end.
+static void testParallelOutput() {
+    static const char* const inputFile = "test_input.txt";
+    static const char* const lines[] = {
+        "2011-01-03 | 3", "2011-01-09 | 1.5", "2012-01-11 | 1000", "2011-02-30 | 1", "2011-01-03 | -1",
+        "2011-01-03 | 1001", "2001-01-01 | 2", "garbage", "", "2011-01-03|3", "2011-01-03 | abc",
+        "2011-01-01 .. 2011-12-31", "2012-01-01 .. 2011-01-01", "2011-01-03 | 2\r", NULL
+    };
+    size_t lineCount = 0;
+    while (lines[lineCount]) ++lineCount;
+
+    writeFile(databaseFile, "date,exchange_rate\n2011-01-03,0.3\n2011-01-09,0.32\n2012-01-11,7.1\n", false);
+    BitcoinExchange exchange(databaseFile);
+    std::remove(databaseFile);
+
+    static const size_t sizes[] = { 40, 700000 };
+    for (size_t s = 0; s < 2; ++s) {
+        std::string input = "date | value\n";
+        std::srand(11);
+        for (size_t i = 0; i < sizes[s]; ++i) {
+            input += lines[std::rand() % lineCount];
+            input += '\n';
+        }
+        input += "2011-01-09 | 2";
+        writeFile(inputFile, input, false);
+
+        std::string serial = captureProcessing(exchange, inputFile, 0);
+        check(serial.size() > sizes[s] * 10, "serial output captured");
+        static const int threadCounts[] = { 1, 3, 4 };
+        for (size_t t = 0; t < 3; ++t) {
+            std::ostringstream what;
+            what << "-j " << threadCounts[t] << " output on " << sizes[s] << " lines";
+            check(captureProcessing(exchange, inputFile, threadCounts[t]) == serial, what.str());
+        }
+    }
+    std::remove(inputFile);
+}
+
+int main() {
+    testParallelOutput();
+    testSnapshot();
+    testQueryRange();
+    testQueryBatch();
+    testIngestAppended();
+    if (failures == 0) std::cout << "All tests passed" << std::endl;
+    return failures;
+}
@@ -0,0 +1,172 @@
+#include "BatchRunner.hpp"
+#include "RPN.hpp"
+#include "RPNStream.hpp"
+#include "Lexer.hpp"
+#include <cstring>
+
+BatchRunner::BatchRunner(const char* data, size_t size, int threadCount)
+    : _data(data), _size(size), _threadCount(threadCount < 1 ? 1 : threadCount) {
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_finished, NULL);
+}
+
+BatchRunner::BatchRunner(const BatchRunner& other) : _data(NULL), _size(0), _threadCount(1) {
+    (void)other;
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_finished, NULL);
+}
+
+BatchRunner& BatchRunner::operator=(const BatchRunner& other) {
+    (void)other;
+    return *this;
+}
+
+BatchRunner::~BatchRunner() {
+    for (size_t i = 0; i < _results.size(); ++i) {
+        delete _results[i];
+    }
+    pthread_cond_destroy(&_finished);
+    pthread_mutex_destroy(&_mutex);
+}
+
+// Pops the next chunk of the worker's own range.
+bool BatchRunner::takeChunk(Worker& worker, size_t& chunk) {
+    pthread_mutex_lock(&worker.mutex);
+    bool found = worker.next < worker.end;
+    if (found) {
+        chunk = worker.next++;
+    }
+    pthread_mutex_unlock(&worker.mutex);
+    return found;
+}
+
+// Moves the back half of the first non-empty range found, starting after
+// the thief, into the thief's own range.
+bool BatchRunner::stealChunks(Worker& thief) {
+    size_t self = static_cast<size_t>(&thief - &_workers[0]);
+    for (size_t i = 1; i < _workers.size(); ++i) {
+        Worker& victim = _workers[(self + i) % _workers.size()];
+        pthread_mutex_lock(&victim.mutex);
+        size_t left = victim.end - victim.next;
+        size_t begin = victim.end - (left + 1) / 2;
+        size_t end = victim.end;
+        victim.end = begin;
+        pthread_mutex_unlock(&victim.mutex);
+        if (begin < end) {
+            pthread_mutex_lock(&thief.mutex);
+            thief.next = begin;
+            thief.end = end;
+            pthread_mutex_unlock(&thief.mutex);
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchRunner::evaluateChunk(Worker& worker, size_t chunk) {
+    std::string* out = new std::string();
+    const char* p = _bounds[chunk];
+    const char* end = _bounds[chunk + 1];
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        bool lastLine = eol == NULL;
+        if (lastLine) eol = end;
+
+        worker.stack.clear();
+        bool empty = true;
+        try {
+            Lexer lexer(p, eol);
+            Lexer::Token token;
+            while (lexer.next(token)) {
+                empty = false;
+                RPN::step(token, worker.stack);
+            }
+            // An unterminated last line that holds nothing is not a line.
+            if (lastLine && empty) break;
+            RPNStream::appendInteger(*out, RPN::result(worker.stack));
+        } catch (const RPN::EvaluationException& e) {
+            *out += e.what();
+            ++worker.failures;
+        }
+        *out += '\n';
+        p = eol + 1;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    _results[chunk] = out;
+    pthread_cond_signal(&_finished);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void* BatchRunner::work(void* arg) {
+    Worker& worker = *static_cast<Worker*>(arg);
+    BatchRunner& runner = *worker.runner;
+    size_t chunk;
+    while (runner.takeChunk(worker, chunk) || (runner.stealChunks(worker) && runner.takeChunk(worker, chunk))) {
+        runner.evaluateChunk(worker, chunk);
+    }
+    return NULL;
+}
+
+size_t BatchRunner::run(int outFd) {
+    const char* p = _data;
+    const char* end = _data + _size;
+    _bounds.push_back(p);
+    while (p < end) {
+        const char* cut = p + (static_cast<size_t>(end - p) < chunkSize ? static_cast<size_t>(end - p) : chunkSize);
+        if (cut < end) {
+            const char* nl = static_cast<const char*>(std::memchr(cut, '\n', static_cast<size_t>(end - cut)));
+            cut = nl ? nl + 1 : end;
+        }
+        _bounds.push_back(cut);
+        p = cut;
+    }
+    size_t chunkCount = _bounds.size() - 1;
+    _results.assign(chunkCount, NULL);
+
+    Worker blank;
+    blank.runner = this;
+    blank.next = 0;
+    blank.end = 0;
+    blank.failures = 0;
+    _workers.assign(_threadCount, blank);
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        pthread_mutex_init(&_workers[i].mutex, NULL);
+        _workers[i].next = chunkCount * i / _workers.size();
+        _workers[i].end = chunkCount * (i + 1) / _workers.size();
+    }
+
+    std::vector<size_t> started;
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        if (pthread_create(&_workers[i].thread, NULL, &BatchRunner::work, &_workers[i]) == 0) {
+            started.push_back(i);
+        }
+    }
+    // Without threads the ranges are still stolen and evaluated, here.
+    if (started.empty()) {
+        work(&_workers[0]);
+    }
+
+    for (size_t i = 0; i < chunkCount; ++i) {
+        pthread_mutex_lock(&_mutex);
+        while (_results[i] == NULL) {
+            pthread_cond_wait(&_finished, &_mutex);
+        }
+        std::string* out = _results[i];
+        _results[i] = NULL;
+        pthread_mutex_unlock(&_mutex);
+
+        RPNStream::writeAll(outFd, *out);
+        delete out;
+    }
+
+    size_t failures = 0;
+    for (size_t i = 0; i < started.size(); ++i) {
+        pthread_join(_workers[started[i]].thread, NULL);
+    }
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        failures += _workers[i].failures;
+        pthread_mutex_destroy(&_workers[i].mutex);
+    }
+    return failures;
+}
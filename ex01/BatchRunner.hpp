@@ -0,0 +1,53 @@
+#ifndef BATCHRUNNER_HPP
+#define BATCHRUNNER_HPP
+
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+// Evaluates a buffer of newline-separated RPN expressions on a pool of
+// threads. The lines are cut into chunks and each worker starts with an
+// equal contiguous range of them; a worker that runs dry steals the back
+// half of another worker's remaining range. Every worker keeps its own
+// evaluation stack. Output matches RPNStream::evaluateLines and is written
+// in input order by the calling thread as chunks complete.
+class BatchRunner {
+public:
+    BatchRunner(const char* data, size_t size, int threadCount);
+    ~BatchRunner();
+
+    // Returns the number of lines that failed.
+    size_t run(int outFd);
+
+private:
+    struct Worker {
+        BatchRunner* runner;
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        size_t next;
+        size_t end;
+        size_t failures;
+        std::vector<int> stack;
+    };
+
+    static const size_t chunkSize = 1 << 16;
+
+    const char* _data;
+    size_t _size;
+    int _threadCount;
+    std::vector<const char*> _bounds;
+    std::vector<std::string*> _results;
+    std::vector<Worker> _workers;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _finished;
+
+    BatchRunner(const BatchRunner& other);
+    BatchRunner& operator=(const BatchRunner& other);
+
+    static void* work(void* arg);
+    bool takeChunk(Worker& worker, size_t& chunk);
+    bool stealChunks(Worker& thief);
+    void evaluateChunk(Worker& worker, size_t chunk);
+};
+
+#endif // BATCHRUNNER_HPP
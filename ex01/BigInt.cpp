@@ -0,0 +1,248 @@
+#include "BigInt.hpp"
+#include <algorithm>
+
+BigInt::BigInt() : _negative(false) {}
+
+BigInt::BigInt(long long value) : _negative(value < 0) {
+    // Negate in unsigned arithmetic so the most negative value is exact.
+    unsigned long long magnitude = static_cast<unsigned long long>(value);
+    if (_negative) magnitude = 0ULL - magnitude;
+    while (magnitude) {
+        _limbs.push_back(static_cast<unsigned int>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInt::BigInt(const BigInt& other) : _negative(other._negative), _limbs(other._limbs) {}
+
+BigInt& BigInt::operator=(const BigInt& other) {
+    if (this != &other) {
+        _negative = other._negative;
+        _limbs = other._limbs;
+    }
+    return *this;
+}
+
+BigInt::~BigInt() {}
+
+BigInt BigInt::fromUnsigned(unsigned long long value) {
+    BigInt result;
+    while (value) {
+        result._limbs.push_back(static_cast<unsigned int>(value));
+        value >>= 32;
+    }
+    return result;
+}
+
+void BigInt::trim() {
+    while (!_limbs.empty() && _limbs.back() == 0) _limbs.pop_back();
+    if (_limbs.empty()) _negative = false;
+}
+
+int BigInt::compareMagnitude(const Limbs& a, const Limbs& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+void BigInt::addMagnitude(const Limbs& a, const Limbs& b, Limbs& result) {
+    const Limbs& longer = a.size() >= b.size() ? a : b;
+    const Limbs& shorter = a.size() >= b.size() ? b : a;
+    result.resize(longer.size() + 1);
+    unsigned long long carry = 0;
+    for (size_t i = 0; i < longer.size(); ++i) {
+        carry += longer[i];
+        if (i < shorter.size()) carry += shorter[i];
+        result[i] = static_cast<unsigned int>(carry);
+        carry >>= 32;
+    }
+    result[longer.size()] = static_cast<unsigned int>(carry);
+}
+
+// Requires |a| >= |b|.
+void BigInt::subtractMagnitude(const Limbs& a, const Limbs& b, Limbs& result) {
+    result.resize(a.size());
+    long long borrow = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        long long difference = static_cast<long long>(a[i]) - borrow - (i < b.size() ? b[i] : 0);
+        borrow = difference < 0 ? 1 : 0;
+        result[i] = static_cast<unsigned int>(difference + (borrow << 32));
+    }
+}
+
+void BigInt::multiplyMagnitude(const Limbs& a, const Limbs& b, Limbs& result) {
+    result.assign(a.size() + b.size(), 0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        unsigned long long carry = 0;
+        for (size_t j = 0; j < b.size(); ++j) {
+            carry += static_cast<unsigned long long>(a[i]) * b[j] + result[i + j];
+            result[i + j] = static_cast<unsigned int>(carry);
+            carry >>= 32;
+        }
+        result[i + b.size()] = static_cast<unsigned int>(carry);
+    }
+}
+
+// Divides a in place and returns the remainder.
+unsigned int BigInt::divideSmall(Limbs& a, unsigned int divisor) {
+    unsigned long long remainder = 0;
+    for (size_t i = a.size(); i-- > 0;) {
+        remainder = (remainder << 32) | a[i];
+        a[i] = static_cast<unsigned int>(remainder / divisor);
+        remainder %= divisor;
+    }
+    return static_cast<unsigned int>(remainder);
+}
+
+// Shift-and-subtract long division, one bit at a time. It is only reached
+// once an exact result no longer fits a machine word, so simplicity wins.
+void BigInt::divideMagnitude(const Limbs& a, const Limbs& b, Limbs& quotient, Limbs& remainder) {
+    quotient.assign(a.size(), 0);
+    remainder.clear();
+    if (b.size() == 1) {
+        quotient = a;
+        unsigned int rest = divideSmall(quotient, b[0]);
+        if (rest) remainder.push_back(rest);
+        return;
+    }
+    for (size_t i = a.size() * 32; i-- > 0;) {
+        // remainder = remainder * 2 + bit i of a
+        unsigned int carry = (a[i / 32] >> (i % 32)) & 1;
+        for (size_t j = 0; j < remainder.size(); ++j) {
+            unsigned int next = remainder[j] >> 31;
+            remainder[j] = (remainder[j] << 1) | carry;
+            carry = next;
+        }
+        if (carry) remainder.push_back(carry);
+        if (compareMagnitude(remainder, b) >= 0) {
+            Limbs difference;
+            subtractMagnitude(remainder, b, difference);
+            while (!difference.empty() && difference.back() == 0) difference.pop_back();
+            remainder.swap(difference);
+            quotient[i / 32] |= 1u << (i % 32);
+        }
+    }
+}
+
+BigInt BigInt::operator-() const {
+    BigInt result(*this);
+    if (!result._limbs.empty()) result._negative = !result._negative;
+    return result;
+}
+
+BigInt BigInt::operator+(const BigInt& other) const {
+    BigInt result;
+    if (_negative == other._negative) {
+        addMagnitude(_limbs, other._limbs, result._limbs);
+        result._negative = _negative;
+    } else if (compareMagnitude(_limbs, other._limbs) >= 0) {
+        subtractMagnitude(_limbs, other._limbs, result._limbs);
+        result._negative = _negative;
+    } else {
+        subtractMagnitude(other._limbs, _limbs, result._limbs);
+        result._negative = other._negative;
+    }
+    result.trim();
+    return result;
+}
+
+BigInt BigInt::operator-(const BigInt& other) const {
+    return *this + -other;
+}
+
+BigInt BigInt::operator*(const BigInt& other) const {
+    BigInt result;
+    multiplyMagnitude(_limbs, other._limbs, result._limbs);
+    result._negative = _negative != other._negative;
+    result.trim();
+    return result;
+}
+
+void BigInt::divide(const BigInt& dividend, const BigInt& divisor, BigInt& quotient, BigInt& remainder) {
+    if (divisor.isZero()) {
+        throw DivisionByZeroException();
+    }
+    BigInt q;
+    BigInt r;
+    divideMagnitude(dividend._limbs, divisor._limbs, q._limbs, r._limbs);
+    q._negative = dividend._negative != divisor._negative;
+    r._negative = dividend._negative;
+    q.trim();
+    r.trim();
+    quotient = q;
+    remainder = r;
+}
+
+BigInt BigInt::operator/(const BigInt& other) const {
+    BigInt quotient;
+    BigInt remainder;
+    divide(*this, other, quotient, remainder);
+    return quotient;
+}
+
+BigInt BigInt::operator%(const BigInt& other) const {
+    BigInt quotient;
+    BigInt remainder;
+    divide(*this, other, quotient, remainder);
+    return remainder;
+}
+
+bool BigInt::operator==(const BigInt& other) const {
+    return _negative == other._negative && _limbs == other._limbs;
+}
+
+bool BigInt::operator<(const BigInt& other) const {
+    if (_negative != other._negative) return _negative;
+    int order = compareMagnitude(_limbs, other._limbs);
+    return _negative ? order > 0 : order < 0;
+}
+
+BigInt BigInt::gcd(const BigInt& a, const BigInt& b) {
+    BigInt x = a.abs();
+    BigInt y = b.abs();
+    while (!y.isZero()) {
+        BigInt r = x % y;
+        x = y;
+        y = r;
+    }
+    return x;
+}
+
+bool BigInt::isZero() const {
+    return _limbs.empty();
+}
+
+bool BigInt::isNegative() const {
+    return _negative;
+}
+
+BigInt BigInt::abs() const {
+    BigInt result(*this);
+    result._negative = false;
+    return result;
+}
+
+std::string BigInt::toString() const {
+    if (_limbs.empty()) return "0";
+
+    // Peel off nine decimal digits per division.
+    std::string digits;
+    Limbs rest = _limbs;
+    while (!rest.empty()) {
+        unsigned int chunk = divideSmall(rest, 1000000000u);
+        while (!rest.empty() && rest.back() == 0) rest.pop_back();
+        for (int i = 0; i < 9 && (chunk || !rest.empty()); ++i) {
+            digits += static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+        }
+    }
+    if (_negative) digits += '-';
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+const char* BigInt::DivisionByZeroException::what() const throw() {
+    return "Division by zero";
+}
@@ -0,0 +1,59 @@
+#ifndef BIGINT_HPP
+#define BIGINT_HPP
+
+#include <exception>
+#include <string>
+#include <vector>
+
+// Arbitrary-precision signed integer: sign and magnitude, the magnitude in
+// little-endian base 2^32 limbs with no leading zero limbs. Division
+// truncates toward zero, like the built-in integer types. Dividing by zero
+// throws DivisionByZeroException, which Rational throws as well.
+class BigInt {
+public:
+    BigInt();
+    explicit BigInt(long long value);
+    BigInt(const BigInt& other);
+    BigInt& operator=(const BigInt& other);
+    ~BigInt();
+
+    static BigInt fromUnsigned(unsigned long long value);
+
+    BigInt operator-() const;
+    BigInt operator+(const BigInt& other) const;
+    BigInt operator-(const BigInt& other) const;
+    BigInt operator*(const BigInt& other) const;
+    BigInt operator/(const BigInt& other) const;
+    BigInt operator%(const BigInt& other) const;
+    bool operator==(const BigInt& other) const;
+    bool operator<(const BigInt& other) const;
+
+    static void divide(const BigInt& dividend, const BigInt& divisor, BigInt& quotient, BigInt& remainder);
+    static BigInt gcd(const BigInt& a, const BigInt& b);
+
+    bool isZero() const;
+    bool isNegative() const;
+    BigInt abs() const;
+    std::string toString() const;
+
+    class DivisionByZeroException : public std::exception {
+        public:
+            virtual const char* what() const throw();
+    };
+
+private:
+    typedef std::vector<unsigned int> Limbs;
+
+    bool _negative;
+    Limbs _limbs;
+
+    void trim();
+    static int compareMagnitude(const Limbs& a, const Limbs& b);
+    static void addMagnitude(const Limbs& a, const Limbs& b, Limbs& result);
+    static void subtractMagnitude(const Limbs& a, const Limbs& b, Limbs& result);
+    static void multiplyMagnitude(const Limbs& a, const Limbs& b, Limbs& result);
+    static unsigned int divideSmall(Limbs& a, unsigned int divisor);
+    static void divideMagnitude(const Limbs& a, const Limbs& b, Limbs& quotient, Limbs& remainder);
+};
+
+#endif // BIGINT_HPP
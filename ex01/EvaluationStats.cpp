@@ -0,0 +1,137 @@
+#include "EvaluationStats.hpp"
+#include <cstdio>
+#include <time.h>
+
+EvaluationStats::EvaluationStats()
+    : _expressions(0), _maxDepth(0), _lexNanoseconds(0), _evalNanoseconds(0) {
+    for (size_t i = 0; i < opcodeCount; ++i) _opcodes[i] = 0;
+    for (size_t i = 0; i < errorKindCount; ++i) _errors[i] = 0;
+}
+
+EvaluationStats::EvaluationStats(const EvaluationStats& other)
+    : _expressions(other._expressions), _maxDepth(other._maxDepth),
+      _lexNanoseconds(other._lexNanoseconds), _evalNanoseconds(other._evalNanoseconds) {
+    for (size_t i = 0; i < opcodeCount; ++i) _opcodes[i] = other._opcodes[i];
+    for (size_t i = 0; i < errorKindCount; ++i) _errors[i] = other._errors[i];
+}
+
+EvaluationStats& EvaluationStats::operator=(const EvaluationStats& other) {
+    if (this != &other) {
+        _expressions = other._expressions;
+        _maxDepth = other._maxDepth;
+        _lexNanoseconds = other._lexNanoseconds;
+        _evalNanoseconds = other._evalNanoseconds;
+        for (size_t i = 0; i < opcodeCount; ++i) _opcodes[i] = other._opcodes[i];
+        for (size_t i = 0; i < errorKindCount; ++i) _errors[i] = other._errors[i];
+    }
+    return *this;
+}
+
+EvaluationStats::~EvaluationStats() {}
+
+// Monotonic time in nanoseconds.
+unsigned long long EvaluationStats::clock() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL + static_cast<unsigned long long>(now.tv_nsec);
+}
+
+void EvaluationStats::countProgram(const Program& program) {
+    ++_expressions;
+    program.countOpcodes(_opcodes);
+    if (program.maxDepth() > _maxDepth) _maxDepth = program.maxDepth();
+}
+
+void EvaluationStats::countError(Program::ErrorKind kind) {
+    ++_errors[kind];
+}
+
+void EvaluationStats::addLexTime(unsigned long long nanoseconds) {
+    _lexNanoseconds += nanoseconds;
+}
+
+void EvaluationStats::addEvalTime(unsigned long long nanoseconds) {
+    _evalNanoseconds += nanoseconds;
+}
+
+void EvaluationStats::merge(const EvaluationStats& other) {
+    _expressions += other._expressions;
+    for (size_t i = 0; i < opcodeCount; ++i) _opcodes[i] += other._opcodes[i];
+    if (other._maxDepth > _maxDepth) _maxDepth = other._maxDepth;
+    for (size_t i = 0; i < errorKindCount; ++i) _errors[i] += other._errors[i];
+    _lexNanoseconds += other._lexNanoseconds;
+    _evalNanoseconds += other._evalNanoseconds;
+}
+
+size_t EvaluationStats::expressions() const {
+    return _expressions;
+}
+
+// Operands and operators; the trap that ends an invalid program is not a
+// token of its own.
+size_t EvaluationStats::tokens() const {
+    size_t total = 0;
+    for (size_t i = 0; i < opcodeCount; ++i) {
+        if (i != Program::OP_TRAP) total += _opcodes[i];
+    }
+    return total;
+}
+
+size_t EvaluationStats::operators(Program::Opcode op) const {
+    return _opcodes[op];
+}
+
+size_t EvaluationStats::maxDepth() const {
+    return _maxDepth;
+}
+
+size_t EvaluationStats::errors(Program::ErrorKind kind) const {
+    return _errors[kind];
+}
+
+unsigned long long EvaluationStats::lexNanoseconds() const {
+    return _lexNanoseconds;
+}
+
+unsigned long long EvaluationStats::evalNanoseconds() const {
+    return _evalNanoseconds;
+}
+
+static void appendLine(std::string& out, const char* label, unsigned long long value) {
+    char line[96];
+    std::snprintf(line, sizeof(line), "%-24s %llu\n", label, value);
+    out += line;
+}
+
+static void appendTime(std::string& out, const char* label, unsigned long long nanoseconds, size_t tokens) {
+    char line[96];
+    std::snprintf(line, sizeof(line), "%-24s %llu ns (%.1f ns/token)\n", label, nanoseconds,
+                  tokens ? static_cast<double>(nanoseconds) / tokens : 0.0);
+    out += line;
+}
+
+// A fixed-layout text report, one counter per line.
+std::string EvaluationStats::report() const {
+    size_t errorTotal = 0;
+    for (size_t i = 0; i < errorKindCount; ++i) errorTotal += _errors[i];
+
+    std::string out;
+    appendLine(out, "expressions", _expressions);
+    appendLine(out, "tokens", tokens());
+    appendLine(out, "  operands", _opcodes[Program::OP_PUSH] + _opcodes[Program::OP_CONSTANT] + _opcodes[Program::OP_LOAD]);
+    appendLine(out, "  +", _opcodes[Program::OP_ADD]);
+    appendLine(out, "  -", _opcodes[Program::OP_SUB]);
+    appendLine(out, "  *", _opcodes[Program::OP_MUL]);
+    appendLine(out, "  /", _opcodes[Program::OP_DIV]);
+    appendLine(out, "max stack depth", _maxDepth);
+    appendLine(out, "errors", errorTotal);
+    appendLine(out, "  invalid token", _errors[Program::ERROR_INVALID_TOKEN]);
+    appendLine(out, "  insufficient operands", _errors[Program::ERROR_INSUFFICIENT_OPERANDS]);
+    appendLine(out, "  leftover operands", _errors[Program::ERROR_LEFTOVER_OPERANDS]);
+    appendLine(out, "  division by zero", _errors[Program::ERROR_DIVISION_BY_ZERO]);
+    appendLine(out, "  literal out of range", _errors[Program::ERROR_LITERAL_RANGE]);
+    appendLine(out, "  division overflow", _errors[Program::ERROR_DIVISION_OVERFLOW]);
+    appendTime(out, "lex and compile", _lexNanoseconds, tokens());
+    appendTime(out, "evaluate", _evalNanoseconds, tokens());
+    return out;
+}
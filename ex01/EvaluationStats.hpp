@@ -0,0 +1,65 @@
+#ifndef EVALUATIONSTATS_HPP
+#define EVALUATIONSTATS_HPP
+
+#include <string>
+#include "Program.hpp"
+
+// Counters for RPN::evaluate(expression, stats): tokens and operators by
+// type, the deepest stack reached, errors by kind, and the time spent
+// lexing and compiling versus running. Token counts come from the compiled
+// program, so the tokenizer and interpreter loops carry no hooks; a token
+// that stopped compilation is counted as an error, not as a token.
+class EvaluationStats {
+public:
+    EvaluationStats();
+    EvaluationStats(const EvaluationStats& other);
+    EvaluationStats& operator=(const EvaluationStats& other);
+    ~EvaluationStats();
+
+    static const bool enabled = true;
+
+    static unsigned long long clock();
+
+    void countProgram(const Program& program);
+    void countError(Program::ErrorKind kind);
+    void addLexTime(unsigned long long nanoseconds);
+    void addEvalTime(unsigned long long nanoseconds);
+    void merge(const EvaluationStats& other);
+
+    size_t expressions() const;
+    size_t tokens() const;
+    size_t operators(Program::Opcode op) const;
+    size_t maxDepth() const;
+    size_t errors(Program::ErrorKind kind) const;
+    unsigned long long lexNanoseconds() const;
+    unsigned long long evalNanoseconds() const;
+
+    std::string report() const;
+
+private:
+    static const size_t opcodeCount = Program::OP_TRAP + 1;
+    static const size_t errorKindCount = Program::ERROR_DIVISION_OVERFLOW + 1;
+
+    size_t _expressions;
+    size_t _opcodes[opcodeCount];
+    size_t _maxDepth;
+    size_t _errors[errorKindCount];
+    unsigned long long _lexNanoseconds;
+    unsigned long long _evalNanoseconds;
+};
+
+// The policy that records nothing. Every hook is an empty inline function
+// and clock() is a constant, so RPN::evaluate instantiated with NoStats is
+// the uninstrumented evaluator.
+struct NoStats {
+    static const bool enabled = false;
+
+    static unsigned long long clock() { return 0; }
+
+    void countProgram(const Program& program) { (void)program; }
+    void countError(Program::ErrorKind kind) { (void)kind; }
+    void addLexTime(unsigned long long nanoseconds) { (void)nanoseconds; }
+    void addEvalTime(unsigned long long nanoseconds) { (void)nanoseconds; }
+};
+
+#endif // EVALUATIONSTATS_HPP
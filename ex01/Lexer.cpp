@@ -0,0 +1,93 @@
+#include "Lexer.hpp"
+
+#define OT CLASS_OTHER
+#define SP CLASS_SPACE
+#define DG CLASS_DIGIT
+#define PT CLASS_POINT
+#define AD CLASS_ADD
+#define SB CLASS_SUB
+#define ML CLASS_MUL
+#define DV CLASS_DIV
+
+const unsigned char Lexer::characterClass[256] = {
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, SP, SP, SP, SP, SP, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    SP, OT, OT, OT, OT, OT, OT, OT, OT, OT, ML, AD, OT, SB, PT, DV,
+    DG, DG, DG, DG, DG, DG, DG, DG, DG, DG, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT
+};
+
+#undef OT
+#undef SP
+#undef DG
+#undef PT
+#undef AD
+#undef SB
+#undef ML
+#undef DV
+
+const Program::Opcode Lexer::classOperator[CLASS_DIV + 1] = {
+    Program::OP_TRAP, Program::OP_TRAP, Program::OP_TRAP, Program::OP_TRAP,
+    Program::OP_ADD, Program::OP_SUB, Program::OP_MUL, Program::OP_DIV
+};
+
+Lexer::Lexer(const char* begin, const char* end) : _position(begin), _end(end) {}
+
+Lexer::Lexer(const Lexer& other) : _position(NULL), _end(NULL) {
+    (void)other;
+}
+
+Lexer& Lexer::operator=(const Lexer& other) {
+    (void)other;
+    return *this;
+}
+
+Lexer::~Lexer() {}
+
+// Fills token with the next word and returns true, or returns false at the
+// end of the input. Operators and numbers are classified; anything else
+// is a word for the caller to interpret. Only a token starting with a
+// digit, a sign or a point is handed to the literal parser.
+bool Lexer::next(Token& token) {
+    const char* p = _position;
+    while (p < _end && isSpace(*p)) ++p;
+    if (p == _end) {
+        _position = p;
+        return false;
+    }
+
+    const char* start = p;
+    while (p < _end && !isSpace(*p)) ++p;
+    _position = p;
+
+    token.text = start;
+    token.length = static_cast<size_t>(p - start);
+    token.kind = TOKEN_WORD;
+    token.op = Program::OP_TRAP;
+    unsigned char type = characterClass[static_cast<unsigned char>(*start)];
+    if (token.length == 1) {
+        if (type == CLASS_DIGIT) {
+            token.kind = TOKEN_NUMBER;
+            token.number = Literal::fromDigit(*start - '0');
+        } else if (type >= CLASS_ADD) {
+            token.kind = TOKEN_OPERATOR;
+            token.op = classOperator[type];
+        }
+    } else if (type == CLASS_DIGIT || type == CLASS_POINT || type == CLASS_ADD || type == CLASS_SUB) {
+        if (Literal::parse(start, token.length, token.number)) {
+            token.kind = TOKEN_NUMBER;
+        }
+    }
+    return true;
+}
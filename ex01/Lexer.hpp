@@ -0,0 +1,61 @@
+#ifndef LEXER_HPP
+#define LEXER_HPP
+
+#include <cstddef>
+#include "Program.hpp"
+#include "Literal.hpp"
+
+// Splits an RPN expression held in memory into tokens without copying or
+// allocating: a token points into the caller's buffer. Characters are
+// classified through a constant 256-entry table, so whitespace, operator
+// and digit tests are a single load each. Whitespace is what
+// std::stringstream >> std::string skips in the C locale. A lone + - * /
+// is an operator; any other token that reads as a Literal is a number.
+class Lexer {
+public:
+    enum TokenKind {
+        TOKEN_OPERATOR,
+        TOKEN_NUMBER,
+        TOKEN_WORD
+    };
+
+    struct Token {
+        TokenKind kind;
+        Program::Opcode op;
+        Literal number;
+        const char* text;
+        size_t length;
+    };
+
+    Lexer(const char* begin, const char* end);
+    ~Lexer();
+
+    bool next(Token& token);
+
+    static bool isSpace(char c) {
+        return characterClass[static_cast<unsigned char>(c)] == CLASS_SPACE;
+    }
+
+private:
+    enum CharacterClass {
+        CLASS_OTHER,
+        CLASS_SPACE,
+        CLASS_DIGIT,
+        CLASS_POINT,
+        CLASS_ADD,
+        CLASS_SUB,
+        CLASS_MUL,
+        CLASS_DIV
+    };
+
+    static const unsigned char characterClass[256];
+    static const Program::Opcode classOperator[CLASS_DIV + 1];
+
+    const char* _position;
+    const char* _end;
+
+    Lexer(const Lexer& other);
+    Lexer& operator=(const Lexer& other);
+};
+
+#endif // LEXER_HPP
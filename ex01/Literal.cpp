@@ -0,0 +1,218 @@
+#include "Literal.hpp"
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+// Every power of ten up to 10^22 is exact in a double.
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const int maxMantissaDigits = 19;
+static const long exponentLimit = 100000;
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static BigInt powerOfTen(long exponent) {
+    BigInt result(1);
+    BigInt base(10);
+    while (exponent > 0) {
+        if (exponent & 1) result = result * base;
+        exponent >>= 1;
+        if (exponent > 0) base = base * base;
+    }
+    return result;
+}
+
+Literal::Literal() : value(0), integer(0), isReal(false), isWhole(true), fitsLongLong(true) {}
+
+Literal::Literal(const Literal& other)
+    : value(other.value), integer(other.integer), isReal(other.isReal), isWhole(other.isWhole),
+      fitsLongLong(other.fitsLongLong) {}
+
+Literal& Literal::operator=(const Literal& other) {
+    if (this != &other) {
+        value = other.value;
+        integer = other.integer;
+        isReal = other.isReal;
+        isWhole = other.isWhole;
+        fitsLongLong = other.fitsLongLong;
+    }
+    return *this;
+}
+
+Literal::~Literal() {}
+
+Literal Literal::fromDigit(int digit) {
+    Literal literal;
+    literal.value = digit;
+    literal.integer = digit;
+    return literal;
+}
+
+// Returns false, leaving literal unspecified, when the token is not a
+// literal or its value is out of the range of double.
+bool Literal::parse(const char* text, size_t length, Literal& literal) {
+    const char* p = text;
+    const char* end = text + length;
+    bool negative = false;
+    if (p != end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // The first maxMantissaDigits significant digits are kept; later ones
+    // only move the decimal exponent, and dropped records whether any of
+    // them was not zero. The value is mantissa * 10^exponent.
+    unsigned long long mantissa = 0;
+    int significant = 0;
+    long exponent = 0;
+    bool dropped = false;
+    size_t digits = 0;
+    bool real = false;
+    for (; p != end && isDigit(*p); ++p, ++digits) {
+        if (significant < maxMantissaDigits) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0) ++significant;
+        } else {
+            ++exponent;
+            dropped |= *p != '0';
+        }
+    }
+    if (p != end && *p == '.') {
+        real = true;
+        for (++p; p != end && isDigit(*p); ++p, ++digits) {
+            if (significant < maxMantissaDigits) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0) ++significant;
+                --exponent;
+            } else {
+                dropped |= *p != '0';
+            }
+        }
+    }
+    if (digits == 0) return false;
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        real = true;
+        ++p;
+        bool negativeExponent = false;
+        if (p != end && (*p == '+' || *p == '-')) {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        if (p == end || !isDigit(*p)) return false;
+        long written = 0;
+        for (; p != end && isDigit(*p); ++p) {
+            if (written < exponentLimit) written = written * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+    if (p != end) return false;
+
+    if (mantissa == 0) {
+        literal = fromDigit(0);
+        literal.value = negative ? -0.0 : 0.0;
+        literal.isReal = real;
+        return true;
+    }
+    // The value lies in [10^(decimalDigits - 1), 10^decimalDigits).
+    long decimalDigits = significant + exponent;
+    if (decimalDigits > DBL_MAX_10_EXP + 1 || decimalDigits < DBL_MIN_10_EXP - DBL_DIG - 1) {
+        return false;
+    }
+
+    // Both factors are exact, so the one rounding of the product or
+    // quotient gives the correctly rounded result.
+    double value;
+    if (!dropped && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+    } else {
+        value = std::fabs(std::strtod(std::string(text, length).c_str(), NULL));
+    }
+    if (value == 0 || value > DBL_MAX) return false;
+    literal.value = negative ? -value : value;
+    literal.isReal = real;
+    literal.integer = 0;
+    literal.fitsLongLong = false;
+
+    if (dropped) {
+        // More than maxMantissaDigits significant digits: a whole value
+        // this long is beyond long long anyway.
+        literal.isWhole = exact(text, length).denominator() == BigInt(1);
+        return true;
+    }
+    while (exponent < 0 && mantissa % 10 == 0) {
+        mantissa /= 10;
+        ++exponent;
+    }
+    literal.isWhole = exponent >= 0;
+    if (!literal.isWhole) return true;
+
+    unsigned long long limit = negative ? 1ULL << 63 : static_cast<unsigned long long>(LLONG_MAX);
+    for (; exponent > 0; --exponent) {
+        if (mantissa > limit / 10) return true;
+        mantissa *= 10;
+    }
+    if (mantissa > limit) return true;
+    literal.fitsLongLong = true;
+    literal.integer = negative ? static_cast<long long>(0 - mantissa) : static_cast<long long>(mantissa);
+    return true;
+}
+
+// The exact value of a literal accepted by parse.
+Rational Literal::exact(const char* text, size_t length) {
+    const char* p = text;
+    const char* end = text + length;
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = *p == '-';
+        ++p;
+    }
+
+    BigInt ten(10);
+    BigInt numerator(0);
+    long exponent = 0;
+    bool fraction = false;
+    for (; p != end && *p != 'e' && *p != 'E'; ++p) {
+        if (*p == '.') {
+            fraction = true;
+            continue;
+        }
+        numerator = numerator * ten + BigInt(*p - '0');
+        if (fraction) --exponent;
+    }
+    // Zero is accepted whatever its exponent, so it must not reach
+    // powerOfTen.
+    if (numerator.isZero()) {
+        return Rational(BigInt());
+    }
+    if (p != end) {
+        ++p;
+        bool negativeExponent = false;
+        if (p != end && (*p == '+' || *p == '-')) {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        long written = 0;
+        for (; p != end; ++p) {
+            if (written < exponentLimit) written = written * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+
+    if (negative) numerator = -numerator;
+    if (exponent >= 0) {
+        return Rational(numerator * powerOfTen(exponent));
+    }
+    return Rational(numerator, powerOfTen(-exponent));
+}
+
+bool Literal::fitsInt() const {
+    return !isReal && fitsLongLong && integer >= INT_MIN && integer <= INT_MAX;
+}
@@ -0,0 +1,37 @@
+#ifndef LITERAL_HPP
+#define LITERAL_HPP
+
+#include <cstddef>
+#include "Rational.hpp"
+
+// A numeric literal: an optional sign, digits with an optional decimal
+// point and an optional exponent, as in 42, -7, 0.25, .5 or 6.02e23.
+// parse reads the token in place, without copying it or going through the
+// locale; the nearest double is computed with exact floating-point
+// operations whenever the decimal mantissa and exponent are small enough,
+// which covers everyday literals, and only longer ones are handed to
+// strtod. Literals beyond the range of double are rejected.
+//
+// A literal written with a point or an exponent is real even when its
+// value is whole: 2.0 and 1e3 are not ints.
+class Literal {
+public:
+    Literal();
+    Literal(const Literal& other);
+    Literal& operator=(const Literal& other);
+    ~Literal();
+
+    double value;
+    long long integer;
+    bool isReal;
+    bool isWhole;
+    bool fitsLongLong;
+
+    static bool parse(const char* text, size_t length, Literal& literal);
+    static Literal fromDigit(int digit);
+    static Rational exact(const char* text, size_t length);
+
+    bool fitsInt() const;
+};
+
+#endif // LITERAL_HPP
@@ -0,0 +1,878 @@
+#include "Program.hpp"
+#include "RPN.hpp"
+#include "Rational.hpp"
+#include "Lexer.hpp"
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <map>
+
+Program::Program() : _maxDepth(0), _variableCount(0), _tempCount(0), _trapKind(ERROR_INVALID_TOKEN) {}
+
+Program::Program(const Program& other)
+    : _code(other._code), _constants(other._constants), _constantText(other._constantText), _maxDepth(other._maxDepth), _variableCount(other._variableCount),
+      _tempCount(other._tempCount), _trapKind(other._trapKind), _trapMessage(other._trapMessage) {}
+
+Program& Program::operator=(const Program& other) {
+    if (this != &other) {
+        _code = other._code;
+        _constants = other._constants;
+        _constantText = other._constantText;
+        _maxDepth = other._maxDepth;
+        _variableCount = other._variableCount;
+        _tempCount = other._tempCount;
+        _trapKind = other._trapKind;
+        _trapMessage = other._trapMessage;
+    }
+    return *this;
+}
+
+Program::~Program() {}
+
+void Program::emit(Opcode op, int value) {
+    Instruction instruction;
+    instruction.op = op;
+    instruction.value = value;
+    _code.push_back(instruction);
+}
+
+void Program::trap(ErrorKind kind, const std::string& message) {
+    _trapKind = kind;
+    _trapMessage = message;
+    emit(OP_TRAP, 0);
+}
+
+// Compiling stops at the first token the interpreter would reject, so at
+// most one trap is emitted and it is always the last instruction. Each
+// character of variables names one variable, bound to the input column of
+// the same index; with none, letters are invalid tokens as before.
+Program Program::compile(const std::string& expression, const std::string& variables) {
+    Program program;
+    program._variableCount = variables.length();
+    size_t depth = 0;
+    Lexer lexer(expression.data(), expression.data() + expression.length());
+    Lexer::Token token;
+
+    while (lexer.next(token)) {
+        if (token.kind == Lexer::TOKEN_OPERATOR) {
+            if (depth < 2) {
+                program.trap(ERROR_INSUFFICIENT_OPERANDS, "Insufficient operands for operator");
+                return program;
+            }
+            program.emit(token.op, 0);
+            --depth;
+        } else if (token.kind == Lexer::TOKEN_NUMBER) {
+            if (token.number.fitsInt()) {
+                program.emit(OP_PUSH, static_cast<int>(token.number.integer));
+            } else {
+                Constant constant;
+                constant.literal = token.number;
+                constant.offset = program._constantText.length();
+                constant.length = token.length;
+                program._constants.push_back(constant);
+                program._constantText.append(token.text, token.length);
+                program.emit(OP_CONSTANT, static_cast<int>(program._constants.size() - 1));
+            }
+            if (++depth > program._maxDepth) program._maxDepth = depth;
+        } else if (token.length == 1 && variables.find(token.text[0]) != std::string::npos) {
+            program.emit(OP_LOAD, static_cast<int>(variables.find(token.text[0])));
+            if (++depth > program._maxDepth) program._maxDepth = depth;
+        } else {
+            program.trap(ERROR_INVALID_TOKEN, "Invalid token: " + std::string(token.text, token.length));
+            return program;
+        }
+    }
+
+    if (depth != 1) {
+        program.trap(ERROR_LEFTOVER_OPERANDS, "Invalid expression: too many operands or operators left");
+    }
+    return program;
+}
+
+// --- Optimization ---
+
+// One node of the expression DAG built by optimized(). Leaves are OP_PUSH,
+// OP_LOAD or OP_CONSTANT; the children of an operator always have smaller
+// ids. A pure node cannot raise an error, so it may be dropped or have its
+// operands reordered. A pool constant is not pure, since evaluating it in
+// int fails, and neither is a division unless its divisor is a literal
+// other than 0 and -1.
+struct ExpressionNode {
+    Program::Opcode op;
+    int value;
+    size_t left;
+    size_t right;
+    bool pure;
+};
+
+static bool isLeaf(Program::Opcode op) {
+    return op == Program::OP_PUSH || op == Program::OP_LOAD || op == Program::OP_CONSTANT;
+}
+
+// Hash-consing: structurally equal nodes are created once, so a repeated
+// subexpression becomes one shared node.
+class ExpressionGraph {
+public:
+    ExpressionGraph() : _table(64, empty) {}
+
+    std::vector<ExpressionNode> nodes;
+
+    size_t leaf(Program::Opcode op, int value) {
+        return intern(op, value, 0, 0, op == Program::OP_PUSH || op == Program::OP_LOAD);
+    }
+
+    size_t combine(Program::Opcode op, size_t left, size_t right) {
+        const ExpressionNode& l = nodes[left];
+        const ExpressionNode& r = nodes[right];
+        bool constants = l.op == Program::OP_PUSH && r.op == Program::OP_PUSH;
+        int folded;
+
+        // Constants fold only when the result is exact in every back-end:
+        // no int overflow, and a division only if it leaves no remainder.
+        // A division by zero is never folded, so it still fails at run time.
+        switch (op) {
+            case Program::OP_ADD:
+                if (constants && !__builtin_add_overflow(l.value, r.value, &folded)) return leaf(Program::OP_PUSH, folded);
+                if (isConstant(right, 0)) return left;
+                if (isConstant(left, 0)) return right;
+                break;
+            case Program::OP_SUB:
+                if (constants && !__builtin_sub_overflow(l.value, r.value, &folded)) return leaf(Program::OP_PUSH, folded);
+                if (isConstant(right, 0)) return left;
+                if (left == right && l.pure) return leaf(Program::OP_PUSH, 0);
+                break;
+            case Program::OP_MUL:
+                if (constants && !__builtin_mul_overflow(l.value, r.value, &folded)) return leaf(Program::OP_PUSH, folded);
+                if (isConstant(right, 1)) return left;
+                if (isConstant(left, 1)) return right;
+                if ((isConstant(right, 0) && l.pure) || (isConstant(left, 0) && r.pure)) return leaf(Program::OP_PUSH, 0);
+                break;
+            case Program::OP_DIV:
+                if (constants && r.value != 0 && r.value != -1 && l.value % r.value == 0) {
+                    return leaf(Program::OP_PUSH, l.value / r.value);
+                }
+                if (isConstant(right, 1)) return left;
+                break;
+            default:
+                break;
+        }
+
+        // Commuted operands are put in a canonical order so that a + b and
+        // b + a share one node, but only when neither can fail: otherwise
+        // the swap would change which error is raised first.
+        if ((op == Program::OP_ADD || op == Program::OP_MUL) && left > right && l.pure && r.pure) {
+            std::swap(left, right);
+        }
+        bool safeDivisor = op != Program::OP_DIV
+            || (nodes[right].op == Program::OP_PUSH && nodes[right].value != 0 && nodes[right].value != -1);
+        return intern(op, 0, left, right, nodes[left].pure && nodes[right].pure && safeDivisor);
+    }
+
+private:
+    static const size_t empty = static_cast<size_t>(-1);
+
+    std::vector<size_t> _table;
+
+    bool isConstant(size_t id, int value) const {
+        return nodes[id].op == Program::OP_PUSH && nodes[id].value == value;
+    }
+
+    static size_t hash(Program::Opcode op, int value, size_t left, size_t right) {
+        size_t h = static_cast<size_t>(op) * 0x9E3779B1u;
+        h = (h ^ static_cast<size_t>(static_cast<unsigned int>(value))) * 0x85EBCA77u;
+        h = (h ^ left) * 0xC2B2AE3Du;
+        h = (h ^ right) * 0x27D4EB2Fu;
+        return h ^ (h >> 15);
+    }
+
+    size_t intern(Program::Opcode op, int value, size_t left, size_t right, bool pure) {
+        size_t mask = _table.size() - 1;
+        size_t slot = hash(op, value, left, right) & mask;
+        while (_table[slot] != empty) {
+            const ExpressionNode& node = nodes[_table[slot]];
+            if (node.op == op && node.value == value && node.left == left && node.right == right) {
+                return _table[slot];
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        ExpressionNode node;
+        node.op = op;
+        node.value = value;
+        node.left = left;
+        node.right = right;
+        node.pure = pure;
+        nodes.push_back(node);
+        _table[slot] = nodes.size() - 1;
+        if (nodes.size() * 2 > _table.size()) {
+            rehash();
+        }
+        return nodes.size() - 1;
+    }
+
+    void rehash() {
+        _table.assign(_table.size() * 2, empty);
+        size_t mask = _table.size() - 1;
+        for (size_t id = 0; id < nodes.size(); ++id) {
+            const ExpressionNode& node = nodes[id];
+            size_t slot = hash(node.op, node.value, node.left, node.right) & mask;
+            while (_table[slot] != empty) slot = (slot + 1) & mask;
+            _table[slot] = id;
+        }
+    }
+};
+
+const size_t ExpressionGraph::empty;
+
+// Returns an equivalent program with constant subexpressions folded,
+// identities such as x + 0 and x * 1 applied and repeated subexpressions
+// computed once. Results and errors are unchanged in every back-end; a
+// program ending in a trap is returned as it is.
+Program Program::optimized() const {
+    if (!_trapMessage.empty() || _code.empty()) {
+        return *this;
+    }
+
+    // Literals with the same text become one leaf, so their uses can be shared.
+    std::map<std::string, int> firstConstant;
+    std::vector<int> canonical(_constants.size());
+    for (size_t i = 0; i < _constants.size(); ++i) {
+        std::string text = _constantText.substr(_constants[i].offset, _constants[i].length);
+        canonical[i] = firstConstant.insert(std::make_pair(text, static_cast<int>(i))).first->second;
+    }
+
+    ExpressionGraph graph;
+    std::vector<size_t> stack;
+    std::vector<size_t> saved(_tempCount);
+    for (size_t i = 0; i < _code.size(); ++i) {
+        const Instruction& instruction = _code[i];
+        switch (instruction.op) {
+            case OP_PUSH:
+            case OP_LOAD:
+                stack.push_back(graph.leaf(instruction.op, instruction.value));
+                break;
+            case OP_CONSTANT:
+                stack.push_back(graph.leaf(instruction.op, canonical[instruction.value]));
+                break;
+            case OP_SAVE:
+                saved[instruction.value] = stack.back();
+                break;
+            case OP_RECALL:
+                stack.push_back(saved[instruction.value]);
+                break;
+            default: {
+                size_t right = stack.back();
+                stack.pop_back();
+                stack.back() = graph.combine(instruction.op, stack.back(), right);
+                break;
+            }
+        }
+    }
+    size_t root = stack[0];
+    const std::vector<ExpressionNode>& nodes = graph.nodes;
+
+    // Count the uses of every node reachable from the root.
+    std::vector<size_t> uses(nodes.size(), 0);
+    uses[root] = 1;
+    for (size_t id = nodes.size(); id-- > 0;) {
+        if (uses[id] && !isLeaf(nodes[id].op)) {
+            ++uses[nodes[id].left];
+            ++uses[nodes[id].right];
+        }
+    }
+
+    // Emit in post-order, left operand first as in the source. The first
+    // evaluation of a shared operator node is saved; later uses recall it.
+    Program program;
+    program._variableCount = _variableCount;
+    program._constants = _constants;
+    program._constantText = _constantText;
+    static const size_t unsaved = static_cast<size_t>(-1);
+    std::vector<size_t> slot(nodes.size(), unsaved);
+    std::vector<std::pair<size_t, bool> > work(1, std::make_pair(root, false));
+    while (!work.empty()) {
+        size_t id = work.back().first;
+        bool expanded = work.back().second;
+        work.pop_back();
+        const ExpressionNode& node = nodes[id];
+        if (isLeaf(node.op)) {
+            program.emit(node.op, node.value);
+        } else if (expanded) {
+            program.emit(node.op, 0);
+            if (uses[id] > 1) {
+                slot[id] = program._tempCount++;
+                program.emit(OP_SAVE, static_cast<int>(slot[id]));
+            }
+        } else if (slot[id] != unsaved) {
+            program.emit(OP_RECALL, static_cast<int>(slot[id]));
+        } else {
+            work.push_back(std::make_pair(id, true));
+            work.push_back(std::make_pair(node.right, false));
+            work.push_back(std::make_pair(node.left, false));
+        }
+    }
+
+    size_t depth = 0;
+    for (size_t i = 0; i < program._code.size(); ++i) {
+        switch (program._code[i].op) {
+            case OP_PUSH:
+            case OP_LOAD:
+            case OP_CONSTANT:
+            case OP_RECALL:
+                if (++depth > program._maxDepth) program._maxDepth = depth;
+                break;
+            case OP_SAVE:
+            case OP_TRAP:
+                break;
+            default:
+                --depth;
+                break;
+        }
+    }
+    return program;
+}
+
+int Program::run() const {
+    return run(NULL);
+}
+
+// variables holds one value per compiled variable, in declaration order.
+int Program::run(const int* variables) const {
+    return evaluateAs<int>(variables);
+}
+
+// Compile-time operator dispatch: every opcode has its own specialization,
+// so each case of the evaluator inlines the arithmetic of the value type.
+template <Program::Opcode Op>
+struct Operation;
+
+template <>
+struct Operation<Program::OP_ADD> {
+    template <typename T>
+    static T apply(T a, T b) { return a + b; }
+};
+
+template <>
+struct Operation<Program::OP_SUB> {
+    template <typename T>
+    static T apply(T a, T b) { return a - b; }
+};
+
+template <>
+struct Operation<Program::OP_MUL> {
+    template <typename T>
+    static T apply(T a, T b) { return a * b; }
+};
+
+// The integer types also reject MIN / -1, whose quotient does not fit
+// and which traps on most machines instead of wrapping.
+template <>
+struct Operation<Program::OP_DIV> {
+    template <typename T>
+    static T apply(T a, T b) {
+        if (b == 0) throw RPN::EvaluationException(Program::ERROR_DIVISION_BY_ZERO, "Division by zero");
+        if (std::numeric_limits<T>::is_integer && b == -1 && a == std::numeric_limits<T>::min()) {
+            throw RPN::EvaluationException(Program::ERROR_DIVISION_OVERFLOW, "Division overflow");
+        }
+        return a / b;
+    }
+};
+
+static std::string constantText(const std::string& pool, const Program::Constant& constant) {
+    return pool.substr(constant.offset, constant.length);
+}
+
+// The value of a pool constant in each evaluation type. Constants never
+// fit in an int, or they would have been pushed directly.
+template <typename T>
+struct ConstantValue;
+
+template <>
+struct ConstantValue<int> {
+    static int get(const Program::Constant& constant, const std::string& pool) {
+        throw RPN::EvaluationException(Program::ERROR_LITERAL_RANGE, "Literal not representable as int: " + constantText(pool, constant));
+    }
+};
+
+template <>
+struct ConstantValue<long long> {
+    static long long get(const Program::Constant& constant, const std::string& pool) {
+        if (constant.literal.isReal || !constant.literal.fitsLongLong) {
+            throw RPN::EvaluationException(Program::ERROR_LITERAL_RANGE, "Literal not representable as long long: " + constantText(pool, constant));
+        }
+        return constant.literal.integer;
+    }
+};
+
+template <>
+struct ConstantValue<double> {
+    static double get(const Program::Constant& constant, const std::string& pool) {
+        (void)pool;
+        return constant.literal.value;
+    }
+};
+
+// Evaluates in T: int (what run() uses), long long or double. Division
+// truncates for the integer types; a zero divisor fails for all of them.
+template <typename T>
+T Program::evaluateAs(const T* variables) const {
+    // Temporaries live right above the deepest stack slot.
+    T local[localStackSize];
+    std::vector<T> heap;
+    T* stack = local;
+    if (_maxDepth + _tempCount > localStackSize) {
+        heap.resize(_maxDepth + _tempCount);
+        stack = &heap[0];
+    }
+    T* temps = stack + _maxDepth;
+
+    // top points one past the last operand; depth was validated by compile.
+    T* top = stack;
+    const Instruction* ip = _code.empty() ? NULL : &_code[0];
+    const Instruction* end = ip + _code.size();
+    for (; ip != end; ++ip) {
+        switch (ip->op) {
+            case OP_PUSH:
+                *top++ = static_cast<T>(ip->value);
+                break;
+            case OP_LOAD:
+                *top++ = variables[ip->value];
+                break;
+            case OP_CONSTANT:
+                *top++ = ConstantValue<T>::get(_constants[ip->value], _constantText);
+                break;
+            case OP_ADD:
+                --top;
+                top[-1] = Operation<OP_ADD>::apply(top[-1], top[0]);
+                break;
+            case OP_SUB:
+                --top;
+                top[-1] = Operation<OP_SUB>::apply(top[-1], top[0]);
+                break;
+            case OP_MUL:
+                --top;
+                top[-1] = Operation<OP_MUL>::apply(top[-1], top[0]);
+                break;
+            case OP_DIV:
+                --top;
+                top[-1] = Operation<OP_DIV>::apply(top[-1], top[0]);
+                break;
+            case OP_SAVE:
+                temps[ip->value] = top[-1];
+                break;
+            case OP_RECALL:
+                *top++ = temps[ip->value];
+                break;
+            case OP_TRAP:
+                throw RPN::EvaluationException(_trapKind, _trapMessage);
+        }
+    }
+    return stack[0];
+}
+
+template int Program::evaluateAs<int>(const int* variables) const;
+template long long Program::evaluateAs<long long>(const long long* variables) const;
+template double Program::evaluateAs<double>(const double* variables) const;
+
+// Evaluates the program once per row, reading variable k of row r from
+// columns[k][r]. Rows are processed batchWidth at a time, structure of
+// arrays: each stack slot holds one value per row of the block, so every
+// instruction is a short loop over contiguous lanes. A division by zero or
+// INT_MIN / -1 only fails its own row, which gets ROW_DIVISION_BY_ZERO or
+// ROW_DIVISION_OVERFLOW, whichever came first, and a result of 0. A
+// program that ends in a trap or uses a literal that is not an int is
+// invalid for every row and throws.
+//
+// The rows run the optimized() program: it is built once for the whole
+// batch, so folding and sharing pay off from the first few blocks.
+void Program::runBatch(const int* const* columns, size_t rows, int* results, unsigned char* status) const {
+    if (!_trapMessage.empty()) {
+        throw RPN::EvaluationException(_trapKind, _trapMessage);
+    }
+    if (!_constants.empty()) {
+        ConstantValue<int>::get(_constants[0], _constantText);
+    }
+    const Program program = optimized();
+
+    int local[localStackSize * batchWidth];
+    std::vector<int> heap;
+    int* stack = local;
+    if (program._maxDepth + program._tempCount > localStackSize) {
+        heap.resize((program._maxDepth + program._tempCount) * batchWidth);
+        stack = &heap[0];
+    }
+
+    size_t row = 0;
+    for (; row + batchWidth <= rows; row += batchWidth) {
+        program.runBlock(columns, row, batchWidth, stack, results, status);
+    }
+    if (row < rows) {
+        program.runBlock(columns, row, rows - row, stack, results, status);
+    }
+}
+
+void Program::runBlock(const int* const* columns, size_t row, size_t width, int* stack,
+                       int* results, unsigned char* status) const {
+    unsigned char* rowStatus = status + row;
+    for (size_t lane = 0; lane < width; ++lane) {
+        rowStatus[lane] = ROW_OK;
+    }
+
+    // top points at the first lane of the slot above the last operand.
+    int* top = stack;
+    int* temps = stack + _maxDepth * batchWidth;
+    for (size_t i = 0; i < _code.size(); ++i) {
+        const Instruction& instruction = _code[i];
+        int* a = top - 2 * batchWidth;
+        int* b = top - batchWidth;
+        switch (instruction.op) {
+            case OP_PUSH:
+                for (size_t lane = 0; lane < width; ++lane) top[lane] = instruction.value;
+                top += batchWidth;
+                break;
+            case OP_LOAD: {
+                const int* column = columns[instruction.value] + row;
+                for (size_t lane = 0; lane < width; ++lane) top[lane] = column[lane];
+                top += batchWidth;
+                break;
+            }
+            case OP_ADD:
+                for (size_t lane = 0; lane < width; ++lane) a[lane] = a[lane] + b[lane];
+                top = b;
+                break;
+            case OP_SUB:
+                for (size_t lane = 0; lane < width; ++lane) a[lane] = a[lane] - b[lane];
+                top = b;
+                break;
+            case OP_MUL:
+                for (size_t lane = 0; lane < width; ++lane) a[lane] = a[lane] * b[lane];
+                top = b;
+                break;
+            case OP_DIV:
+                // A zero divisor, or -1 under INT_MIN, is replaced by 1 so
+                // the lane keeps going; its row is already marked as failed.
+                for (size_t lane = 0; lane < width; ++lane) {
+                    if (b[lane] == 0) {
+                        if (rowStatus[lane] == ROW_OK) rowStatus[lane] = ROW_DIVISION_BY_ZERO;
+                        b[lane] = 1;
+                    } else if (b[lane] == -1 && a[lane] == INT_MIN) {
+                        if (rowStatus[lane] == ROW_OK) rowStatus[lane] = ROW_DIVISION_OVERFLOW;
+                        b[lane] = 1;
+                    }
+                    a[lane] = a[lane] / b[lane];
+                }
+                top = b;
+                break;
+            case OP_SAVE: {
+                int* slot = temps + instruction.value * batchWidth;
+                for (size_t lane = 0; lane < width; ++lane) slot[lane] = b[lane];
+                break;
+            }
+            case OP_RECALL: {
+                const int* slot = temps + instruction.value * batchWidth;
+                for (size_t lane = 0; lane < width; ++lane) top[lane] = slot[lane];
+                top += batchWidth;
+                break;
+            }
+            case OP_CONSTANT:
+            case OP_TRAP:
+                break;
+        }
+    }
+
+    for (size_t lane = 0; lane < width; ++lane) {
+        results[row + lane] = rowStatus[lane] == ROW_OK ? stack[lane] : 0;
+    }
+}
+
+// Overflow-checked native arithmetic for runExact. Each operation returns
+// false instead of producing a wrapped result.
+struct Checked64 {
+    typedef long long Value;
+
+    static bool add(Value a, Value b, Value& result) { return !__builtin_add_overflow(a, b, &result); }
+    static bool subtract(Value a, Value b, Value& result) { return !__builtin_sub_overflow(a, b, &result); }
+    static bool multiply(Value a, Value b, Value& result) { return !__builtin_mul_overflow(a, b, &result); }
+
+    static BigInt toBigInt(Value value) {
+        return BigInt(value);
+    }
+};
+
+struct Checked128 {
+    typedef __int128 Value;
+
+    static bool add(Value a, Value b, Value& result) { return !__builtin_add_overflow(a, b, &result); }
+    static bool subtract(Value a, Value b, Value& result) { return !__builtin_sub_overflow(a, b, &result); }
+    static bool multiply(Value a, Value b, Value& result) { return !__builtin_mul_overflow(a, b, &result); }
+
+    static BigInt toBigInt(Value value) {
+        unsigned __int128 magnitude = static_cast<unsigned __int128>(value);
+        if (value < 0) magnitude = 0 - magnitude;
+        BigInt result = BigInt::fromUnsigned(static_cast<unsigned long long>(magnitude >> 64))
+            * BigInt::fromUnsigned(1ULL << 32) * BigInt::fromUnsigned(1ULL << 32)
+            + BigInt::fromUnsigned(static_cast<unsigned long long>(magnitude));
+        return value < 0 ? -result : result;
+    }
+};
+
+// Decimal text of a native integer, without going through BigInt.
+template <typename Value>
+static std::string formatInteger(Value value) {
+    char digits[48];
+    char* p = digits + sizeof(digits);
+    bool negative = value < 0;
+    do {
+        Value digit = value % 10;
+        *--p = static_cast<char>('0' + (negative ? -digit : digit));
+        value /= 10;
+    } while (value != 0);
+    if (negative) *--p = '-';
+    return std::string(p, digits + sizeof(digits));
+}
+
+// The integer back-ends accept only whole literals.
+static void requireWhole(const Program::Constant& constant, const std::string& pool) {
+    if (!constant.literal.isWhole) {
+        throw RPN::EvaluationException(Program::ERROR_LITERAL_RANGE, "Literal not an integer: " + constantText(pool, constant));
+    }
+}
+
+// Runs the program natively until it finishes or an operation overflows.
+// On overflow, ip is left on the failing instruction and the stack, its
+// operands included, and the temporaries are handed back as BigInts so
+// evaluation can resume. A whole literal beyond long long counts as an
+// overflow of the instruction that pushes it.
+template <typename Arithmetic>
+static bool runNative(const std::vector<Program::Instruction>& code, const std::vector<Program::Constant>& constants,
+                      const std::string& constantPool, size_t maxDepth, size_t tempCount, const int* variables,
+                      Program::ErrorKind trapKind, const std::string& trapMessage, size_t& ip,
+                      std::vector<BigInt>& spill, std::vector<BigInt>& tempSpill, std::string& result) {
+    typedef typename Arithmetic::Value Value;
+    static const size_t localStackSize = 64;
+
+    Value local[localStackSize];
+    std::vector<Value> heap;
+    Value* stack = local;
+    if (maxDepth + tempCount > localStackSize) {
+        heap.resize(maxDepth + tempCount);
+        stack = &heap[0];
+    }
+    Value* temps = stack + maxDepth;
+    for (size_t i = 0; i < tempCount; ++i) {
+        temps[i] = 0;
+    }
+
+    Value* top = stack;
+    for (ip = 0; ip < code.size(); ++ip) {
+        const Program::Instruction& instruction = code[ip];
+        Value value = 0;
+        bool exact = true;
+        switch (instruction.op) {
+            case Program::OP_PUSH:
+                *top++ = instruction.value;
+                continue;
+            case Program::OP_LOAD:
+                *top++ = variables[instruction.value];
+                continue;
+            case Program::OP_CONSTANT:
+                requireWhole(constants[instruction.value], constantPool);
+                if (constants[instruction.value].literal.fitsLongLong) {
+                    *top++ = constants[instruction.value].literal.integer;
+                    continue;
+                }
+                exact = false;
+                break;
+            case Program::OP_SAVE:
+                temps[instruction.value] = top[-1];
+                continue;
+            case Program::OP_RECALL:
+                *top++ = temps[instruction.value];
+                continue;
+            case Program::OP_ADD:
+                exact = Arithmetic::add(top[-2], top[-1], value);
+                break;
+            case Program::OP_SUB:
+                exact = Arithmetic::subtract(top[-2], top[-1], value);
+                break;
+            case Program::OP_MUL:
+                exact = Arithmetic::multiply(top[-2], top[-1], value);
+                break;
+            case Program::OP_DIV:
+                if (top[-1] == 0) throw RPN::EvaluationException(Program::ERROR_DIVISION_BY_ZERO, "Division by zero");
+                // The only overflowing quotient is MIN / -1, i.e. -MIN.
+                if (top[-1] == -1) {
+                    exact = Arithmetic::subtract(0, top[-2], value);
+                } else {
+                    value = top[-2] / top[-1];
+                }
+                break;
+            case Program::OP_TRAP:
+                throw RPN::EvaluationException(trapKind, trapMessage);
+        }
+        if (!exact) {
+            for (Value* p = stack; p != top; ++p) {
+                spill.push_back(Arithmetic::toBigInt(*p));
+            }
+            for (size_t i = 0; i < tempCount; ++i) {
+                tempSpill.push_back(Arithmetic::toBigInt(temps[i]));
+            }
+            return false;
+        }
+        --top;
+        top[-1] = value;
+    }
+    result = formatInteger(stack[0]);
+    return true;
+}
+
+// Exact evaluation; returns the result as decimal text ("p/q" for a
+// non-integral rational). Errors are the same as run(): the arithmetic
+// types report division by zero on their own, and it is translated here.
+std::string Program::runExact(Backend backend, const int* variables) const {
+    try {
+        return runExactUnchecked(backend, variables);
+    } catch (const BigInt::DivisionByZeroException& e) {
+        throw RPN::EvaluationException(ERROR_DIVISION_BY_ZERO, "Division by zero");
+    }
+}
+
+std::string Program::runExactUnchecked(Backend backend, const int* variables) const {
+    std::vector<BigInt> stack;
+    std::vector<BigInt> temps;
+    std::string result;
+    size_t ip = 0;
+    switch (backend) {
+        case BACKEND_CHECKED64:
+            if (runNative<Checked64>(_code, _constants, _constantText, _maxDepth, _tempCount, variables, _trapKind, _trapMessage, ip, stack, temps, result)) {
+                return result;
+            }
+            break;
+        case BACKEND_INT128:
+            if (runNative<Checked128>(_code, _constants, _constantText, _maxDepth, _tempCount, variables, _trapKind, _trapMessage, ip, stack, temps, result)) {
+                return result;
+            }
+            break;
+        case BACKEND_BIGINT:
+            temps.resize(_tempCount);
+            break;
+        case BACKEND_RATIONAL:
+            return runRational(variables);
+    }
+    return runBigInt(ip, stack, temps, variables);
+}
+
+// Evaluates from instruction ip onwards with stack already holding the
+// operands produced before it.
+std::string Program::runBigInt(size_t ip, std::vector<BigInt>& stack, std::vector<BigInt>& temps,
+                               const int* variables) const {
+    stack.reserve(_maxDepth);
+    for (; ip < _code.size(); ++ip) {
+        const Instruction& instruction = _code[ip];
+        if (instruction.op == OP_PUSH) {
+            stack.push_back(BigInt(instruction.value));
+            continue;
+        }
+        if (instruction.op == OP_LOAD) {
+            stack.push_back(BigInt(variables[instruction.value]));
+            continue;
+        }
+        if (instruction.op == OP_CONSTANT) {
+            const Constant& constant = _constants[instruction.value];
+            requireWhole(constant, _constantText);
+            stack.push_back(Literal::exact(_constantText.data() + constant.offset, constant.length).numerator());
+            continue;
+        }
+        if (instruction.op == OP_SAVE) {
+            temps[instruction.value] = stack.back();
+            continue;
+        }
+        if (instruction.op == OP_RECALL) {
+            stack.push_back(temps[instruction.value]);
+            continue;
+        }
+        if (instruction.op == OP_TRAP) {
+            throw RPN::EvaluationException(_trapKind, _trapMessage);
+        }
+        BigInt right = stack.back();
+        stack.pop_back();
+        BigInt& left = stack.back();
+        switch (instruction.op) {
+            case OP_ADD: left = left + right; break;
+            case OP_SUB: left = left - right; break;
+            case OP_MUL: left = left * right; break;
+            case OP_DIV: left = left / right; break;
+            default: break;
+        }
+    }
+    return stack[0].toString();
+}
+
+std::string Program::runRational(const int* variables) const {
+    std::vector<Rational> stack;
+    std::vector<Rational> temps(_tempCount);
+    stack.reserve(_maxDepth);
+    for (size_t ip = 0; ip < _code.size(); ++ip) {
+        const Instruction& instruction = _code[ip];
+        if (instruction.op == OP_PUSH) {
+            stack.push_back(Rational(BigInt(instruction.value)));
+            continue;
+        }
+        if (instruction.op == OP_LOAD) {
+            stack.push_back(Rational(BigInt(variables[instruction.value])));
+            continue;
+        }
+        if (instruction.op == OP_CONSTANT) {
+            const Constant& constant = _constants[instruction.value];
+            stack.push_back(Literal::exact(_constantText.data() + constant.offset, constant.length));
+            continue;
+        }
+        if (instruction.op == OP_SAVE) {
+            temps[instruction.value] = stack.back();
+            continue;
+        }
+        if (instruction.op == OP_RECALL) {
+            stack.push_back(temps[instruction.value]);
+            continue;
+        }
+        if (instruction.op == OP_TRAP) {
+            throw RPN::EvaluationException(_trapKind, _trapMessage);
+        }
+        Rational right = stack.back();
+        stack.pop_back();
+        Rational& left = stack.back();
+        switch (instruction.op) {
+            case OP_ADD: left = left + right; break;
+            case OP_SUB: left = left - right; break;
+            case OP_MUL: left = left * right; break;
+            case OP_DIV: left = left / right; break;
+            default: break;
+        }
+    }
+    return stack[0].toString();
+}
+
+size_t Program::size() const {
+    return _code.size();
+}
+
+size_t Program::maxDepth() const {
+    return _maxDepth;
+}
+
+size_t Program::variableCount() const {
+    return _variableCount;
+}
+
+// counts must hold OP_TRAP + 1 entries; each gets the number of
+// instructions with that opcode added to it.
+void Program::countOpcodes(size_t* counts) const {
+    for (size_t i = 0; i < _code.size(); ++i) {
+        ++counts[_code[i].op];
+    }
+}
+
+// True when every literal fits in an int, so run() cannot fail on one.
+bool Program::integerOnly() const {
+    return _constants.empty();
+}
@@ -0,0 +1,125 @@
+#ifndef PROGRAM_HPP
+#define PROGRAM_HPP
+
+#include <string>
+#include <vector>
+#include "BigInt.hpp"
+#include "Literal.hpp"
+
+// A compiled RPN expression: a flat instruction array whose stack depth was
+// checked at compile time, so running it needs no underflow checks and no
+// allocation for expressions up to localStackSize deep. An expression that
+// cannot run to completion ends in a trap instruction carrying the error
+// the interpreter would have raised at that point; anything evaluated
+// before it, such as a division by zero, still fails first.
+//
+// Literals that fit in an int are pushed directly; any other literal, such
+// as 2.5 or 1e12, is kept in a constant pool and pushed with OP_CONSTANT.
+// Evaluating in int fails on such a constant when it is reached; the wider
+// evaluators and the exact back-ends accept what they can represent.
+//
+// Single-letter variables named at compile time read their value from a
+// column of inputs, so one program can be run over whole datasets.
+//
+// optimized() folds constants and shares repeated subexpressions; a shared
+// value is computed once, kept in a temporary slot with OP_SAVE and pushed
+// again with OP_RECALL.
+class Program {
+public:
+    enum Opcode {
+        OP_PUSH,
+        OP_LOAD,
+        OP_CONSTANT,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_SAVE,
+        OP_RECALL,
+        OP_TRAP
+    };
+
+    struct Instruction {
+        Opcode op;
+        int value;
+    };
+
+    // The text of a constant is kept for error messages and for the
+    // exact back-ends, at offset in one string shared by the pool.
+    struct Constant {
+        Literal literal;
+        size_t offset;
+        size_t length;
+    };
+
+    Program();
+    Program(const Program& other);
+    Program& operator=(const Program& other);
+    ~Program();
+
+    // What an evaluation error is about, for callers that count them.
+    enum ErrorKind {
+        ERROR_INVALID_TOKEN,
+        ERROR_INSUFFICIENT_OPERANDS,
+        ERROR_LEFTOVER_OPERANDS,
+        ERROR_DIVISION_BY_ZERO,
+        ERROR_LITERAL_RANGE,
+        ERROR_DIVISION_OVERFLOW
+    };
+
+    enum RowStatus {
+        ROW_OK,
+        ROW_DIVISION_BY_ZERO,
+        ROW_DIVISION_OVERFLOW
+    };
+
+    // Exact arithmetic for runExact. The two native back-ends detect
+    // overflow and finish the evaluation in BACKEND_BIGINT from the
+    // instruction that overflowed; division truncates as with int.
+    // BACKEND_RATIONAL keeps every quotient exact.
+    enum Backend {
+        BACKEND_CHECKED64,
+        BACKEND_INT128,
+        BACKEND_BIGINT,
+        BACKEND_RATIONAL
+    };
+
+    static Program compile(const std::string& expression, const std::string& variables = "");
+    Program optimized() const;
+
+    int run() const;
+    int run(const int* variables) const;
+    template <typename T>
+    T evaluateAs(const T* variables = NULL) const;
+    std::string runExact(Backend backend, const int* variables = NULL) const;
+    void runBatch(const int* const* columns, size_t rows, int* results, unsigned char* status) const;
+    size_t size() const;
+    size_t maxDepth() const;
+    size_t variableCount() const;
+    bool integerOnly() const;
+    void countOpcodes(size_t* counts) const;
+
+private:
+    static const size_t localStackSize = 64;
+    static const size_t batchWidth = 16;
+
+    std::vector<Instruction> _code;
+    std::vector<Constant> _constants;
+    std::string _constantText;
+    size_t _maxDepth;
+    size_t _variableCount;
+    size_t _tempCount;
+    ErrorKind _trapKind;
+    std::string _trapMessage;
+
+    void emit(Opcode op, int value);
+    void trap(ErrorKind kind, const std::string& message);
+    std::string runExactUnchecked(Backend backend, const int* variables) const;
+    std::string runBigInt(size_t ip, std::vector<BigInt>& stack, std::vector<BigInt>& temps,
+                          const int* variables) const;
+    std::string runRational(const int* variables) const;
+    void runBlock(const int* const* columns, size_t row, size_t width, int* stack,
+                  int* results, unsigned char* status) const;
+};
+
+#endif // PROGRAM_HPP
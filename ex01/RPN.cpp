@@ -1,8 +1,7 @@
 #include "RPN.hpp"
-#include <sstream>
+#include "EvaluationStats.hpp"
 #include <string>
-#include <cstdlib> // For std::atoi
-#include <iostream> // For cerr (if needed in helper, though likely not)
+#include <climits>
 
 RPN::RPN() { }
 RPN::RPN(const RPN& other) { (void)other; }
@@ -10,53 +9,100 @@ RPN& RPN::operator=(const RPN& other) { (void)other; return *this; }
 RPN::~RPN() { }
 
 
-int RPN::performOp(int a, int b, char op) {
-    switch (op) {
-        case '+': return a + b;
-        case '-': return a - b;
-        case '*': return a * b;
-        case '/': 
-            if (b == 0) throw EvaluationException("Division by zero");
-            return a / b;
-        default: 
-            throw EvaluationException("Invalid operator"); 
+// Compiles the expression once; the returned program can be run any number
+// of times and raises the same errors, in the same order, as evaluate.
+// variables lists the single-letter names the expression may read.
+Program RPN::compile(const std::string& expression, const std::string& variables) {
+    return Program::compile(expression, variables);
+}
+
+int RPN::evaluate(const std::string& expression) {
+    NoStats stats;
+    return evaluate(expression, stats);
+}
+
+// Same result and errors as evaluate(expression). Stats is EvaluationStats
+// to record counters and timings, or NoStats to record nothing.
+template <typename Stats>
+int RPN::evaluate(const std::string& expression, Stats& stats) {
+    unsigned long long start = Stats::clock();
+    Program program = Program::compile(expression);
+    unsigned long long compiled = Stats::clock();
+    stats.addLexTime(compiled - start);
+    stats.countProgram(program);
+    // Catching only to count would make every error a rethrow.
+    if (!Stats::enabled) {
+        return program.run();
+    }
+    try {
+        int result = program.run();
+        stats.addEvalTime(Stats::clock() - compiled);
+        return result;
+    } catch (const EvaluationException& e) {
+        stats.addEvalTime(Stats::clock() - compiled);
+        stats.countError(e.kind());
+        throw;
     }
 }
 
+template int RPN::evaluate<NoStats>(const std::string& expression, NoStats& stats);
+template int RPN::evaluate<EvaluationStats>(const std::string& expression, EvaluationStats& stats);
 
-int RPN::evaluate(const std::string& expression) {
-    std::stack<int> stack;
-    std::stringstream ss(expression);
-    std::string token;
-
-    while (ss >> token) {
-        if (token.length() == 1 && std::string("+-*/").find(token[0]) != std::string::npos) {
-           if (stack.size() < 2) {
-                throw EvaluationException("Insufficient operands for operator");
-            }
-            int operand2 = stack.top(); stack.pop();
-            int operand1 = stack.top(); stack.pop();
-            stack.push(performOp(operand1, operand2, token[0]));
-        } else {
-            
-            if (token.length() != 1 || !std::isdigit(token[0])) {
-                 throw EvaluationException("Invalid token: " + token);
-            }
-            stack.push(std::atoi(token.c_str()));
+// Applies one token to a caller-owned stack, for evaluators that see the
+// expression a token at a time. Same checks and messages as evaluate.
+void RPN::step(const char* token, size_t length, std::vector<int>& stack) {
+    Lexer lexer(token, token + length);
+    Lexer::Token classified;
+    lexer.next(classified);
+    step(classified, stack);
+}
+
+void RPN::step(const Lexer::Token& token, std::vector<int>& stack) {
+    if (token.kind == Lexer::TOKEN_NUMBER) {
+        if (!token.number.fitsInt()) {
+            throw EvaluationException(Program::ERROR_LITERAL_RANGE, "Literal not representable as int: " + std::string(token.text, token.length));
         }
+        stack.push_back(static_cast<int>(token.number.integer));
+        return;
+    }
+    if (token.kind == Lexer::TOKEN_WORD) {
+        throw EvaluationException(Program::ERROR_INVALID_TOKEN, "Invalid token: " + std::string(token.text, token.length));
+    }
+    if (stack.size() < 2) {
+        throw EvaluationException(Program::ERROR_INSUFFICIENT_OPERANDS, "Insufficient operands for operator");
+    }
+    int b = stack.back();
+    stack.pop_back();
+    int& a = stack.back();
+    switch (token.op) {
+        case Program::OP_ADD: a = a + b; break;
+        case Program::OP_SUB: a = a - b; break;
+        case Program::OP_MUL: a = a * b; break;
+        default:
+            if (b == 0) throw EvaluationException(Program::ERROR_DIVISION_BY_ZERO, "Division by zero");
+            if (b == -1 && a == INT_MIN) throw EvaluationException(Program::ERROR_DIVISION_OVERFLOW, "Division overflow");
+            a = a / b;
+            break;
     }
+}
 
+// The value of a stack after the last token.
+int RPN::result(const std::vector<int>& stack) {
     if (stack.size() != 1) {
-        throw EvaluationException("Invalid expression: too many operands or operators left");
+        throw EvaluationException(Program::ERROR_LEFTOVER_OPERANDS, "Invalid expression: too many operands or operators left");
     }
-
-    return stack.top();
+    return stack[0];
 }
 
-RPN::EvaluationException::EvaluationException(const std::string& message) : _message("Error: " + message) {}
+RPN::EvaluationException::EvaluationException(Program::ErrorKind kind, const std::string& message)
+    : _kind(kind), _message("Error: " + message) {}
 
 RPN::EvaluationException::~EvaluationException() throw() {}
 
 const char* RPN::EvaluationException::what() const throw() {
     return _message.c_str();
 }
+
+Program::ErrorKind RPN::EvaluationException::kind() const {
+    return _kind;
+}
@@ -2,8 +2,10 @@
 #define RPN_HPP
 
 #include <string>
-#include <stack>
+#include <vector>
 #include <stdexcept>
+#include "Program.hpp"
+#include "Lexer.hpp"
 
 class RPN {
 private:
@@ -12,18 +14,24 @@ private:
     RPN& operator=(const RPN& other);
     ~RPN();
 
-    static int performOp(int a, int b, char op);
-
 public:
     static int evaluate(const std::string& expression);
+    template <typename Stats>
+    static int evaluate(const std::string& expression, Stats& stats);
+    static Program compile(const std::string& expression, const std::string& variables = "");
+    static void step(const char* token, size_t length, std::vector<int>& stack);
+    static void step(const Lexer::Token& token, std::vector<int>& stack);
+    static int result(const std::vector<int>& stack);
 
     class EvaluationException : public std::exception {
         private:
+            Program::ErrorKind _kind;
             std::string _message;
         public:
-            EvaluationException(const std::string& message);
+            EvaluationException(Program::ErrorKind kind, const std::string& message);
             virtual ~EvaluationException() throw(); // Destructor needs throw()
             virtual const char* what() const throw();
+            Program::ErrorKind kind() const;
     };
 };
 
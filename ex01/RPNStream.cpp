@@ -0,0 +1,139 @@
+#include "RPNStream.hpp"
+#include "RPN.hpp"
+#include "Lexer.hpp"
+#include <cerrno>
+#include <unistd.h>
+
+RPNStream::RPNStream(int fd) : _fd(fd), _buffer(bufferSize), _position(0), _length(0), _eof(false) {}
+
+RPNStream::RPNStream(const RPNStream& other) : _fd(-1), _position(0), _length(0), _eof(true) {
+    (void)other;
+}
+
+RPNStream& RPNStream::operator=(const RPNStream& other) {
+    (void)other;
+    return *this;
+}
+
+RPNStream::~RPNStream() {}
+
+bool RPNStream::fill() {
+    while (!_eof) {
+        ssize_t n = read(_fd, &_buffer[0], _buffer.size());
+        if (n > 0) {
+            _position = 0;
+            _length = static_cast<size_t>(n);
+            return true;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        _eof = true;
+    }
+    return false;
+}
+
+// Reads the next whitespace-separated word into _token. With newlines set,
+// a line break is reported as its own token instead of being skipped.
+RPNStream::TokenKind RPNStream::nextToken(bool newlines) {
+    _token.clear();
+    while (true) {
+        if (_position == _length && !fill()) {
+            return _token.empty() ? TOKEN_END : TOKEN_WORD;
+        }
+        char c = _buffer[_position];
+        if (Lexer::isSpace(c)) {
+            if (!_token.empty()) return TOKEN_WORD;
+            ++_position;
+            if (c == '\n' && newlines) return TOKEN_NEWLINE;
+            continue;
+        }
+        // A word may continue into the next buffer, so it is accumulated.
+        size_t start = _position;
+        while (_position < _length && !Lexer::isSpace(_buffer[_position])) ++_position;
+        _token.append(&_buffer[start], _position - start);
+    }
+}
+
+void RPNStream::apply() {
+    RPN::step(_token.data(), _token.length(), _stack);
+}
+
+int RPNStream::finish() {
+    return RPN::result(_stack);
+}
+
+int RPNStream::evaluateAll() {
+    _stack.clear();
+    while (nextToken(false) == TOKEN_WORD) {
+        apply();
+    }
+    return finish();
+}
+
+void RPNStream::writeAll(int fd, const std::string& text) {
+    size_t done = 0;
+    while (done < text.size()) {
+        ssize_t n = write(fd, text.data() + done, text.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        done += static_cast<size_t>(n);
+    }
+}
+
+void RPNStream::appendInteger(std::string& out, int value) {
+    char digits[16];
+    char* p = digits + sizeof(digits);
+    unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+    do {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) *--p = '-';
+    out.append(p, digits + sizeof(digits));
+}
+
+size_t RPNStream::evaluateLines(int outFd) {
+    std::string out;
+    size_t failures = 0;
+    bool pending = false;
+
+    while (true) {
+        _stack.clear();
+        std::string error;
+        TokenKind kind;
+        // After an error the rest of the line is read but not evaluated.
+        while ((kind = nextToken(true)) == TOKEN_WORD) {
+            pending = true;
+            if (!error.empty()) continue;
+            try {
+                apply();
+            } catch (const RPN::EvaluationException& e) {
+                error = e.what();
+            }
+        }
+        // A final line without a newline still counts; an empty tail does not.
+        if (kind == TOKEN_END && !pending) break;
+
+        if (error.empty()) {
+            try {
+                appendInteger(out, finish());
+            } catch (const RPN::EvaluationException& e) {
+                error = e.what();
+            }
+        }
+        if (!error.empty()) {
+            out += error;
+            ++failures;
+        }
+        out += '\n';
+        if (out.size() >= flushSize) {
+            writeAll(outFd, out);
+            out.clear();
+        }
+        pending = false;
+        if (kind == TOKEN_END) break;
+    }
+    writeAll(outFd, out);
+    return failures;
+}
@@ -0,0 +1,53 @@
+#ifndef RPNSTREAM_HPP
+#define RPNSTREAM_HPP
+
+#include <string>
+#include <vector>
+
+// Evaluates RPN read from a file descriptor through a fixed-size buffer,
+// tokenizing across buffer boundaries, so memory grows with the stack
+// depth of the expression rather than with the size of the input.
+// Arithmetic and error messages are those of RPN::evaluate.
+class RPNStream {
+public:
+    explicit RPNStream(int fd);
+    ~RPNStream();
+
+    // The whole input is one expression; newlines are plain whitespace.
+    int evaluateAll();
+    // Every line is an expression. Each input line produces one output line
+    // on outFd, either the result or the error text. Returns the number of
+    // lines that failed.
+    size_t evaluateLines(int outFd);
+
+    static void writeAll(int fd, const std::string& text);
+    static void appendInteger(std::string& out, int value);
+
+private:
+    enum TokenKind {
+        TOKEN_WORD,
+        TOKEN_NEWLINE,
+        TOKEN_END
+    };
+
+    static const size_t bufferSize = 1 << 16;
+    static const size_t flushSize = 1 << 16;
+
+    int _fd;
+    std::vector<char> _buffer;
+    size_t _position;
+    size_t _length;
+    bool _eof;
+    std::vector<int> _stack;
+    std::string _token;
+
+    RPNStream(const RPNStream& other);
+    RPNStream& operator=(const RPNStream& other);
+
+    bool fill();
+    TokenKind nextToken(bool newlines);
+    void apply();
+    int finish();
+};
+
+#endif // RPNSTREAM_HPP
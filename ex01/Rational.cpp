@@ -0,0 +1,79 @@
+#include "Rational.hpp"
+
+Rational::Rational() : _numerator(0), _denominator(1) {}
+
+Rational::Rational(const BigInt& numerator) : _numerator(numerator), _denominator(1) {}
+
+Rational::Rational(const BigInt& numerator, const BigInt& denominator)
+    : _numerator(numerator), _denominator(denominator) {
+    if (_denominator.isZero()) {
+        throw BigInt::DivisionByZeroException();
+    }
+    normalize();
+}
+
+Rational::Rational(const Rational& other) : _numerator(other._numerator), _denominator(other._denominator) {}
+
+Rational& Rational::operator=(const Rational& other) {
+    if (this != &other) {
+        _numerator = other._numerator;
+        _denominator = other._denominator;
+    }
+    return *this;
+}
+
+Rational::~Rational() {}
+
+void Rational::normalize() {
+    if (_denominator.isNegative()) {
+        _numerator = -_numerator;
+        _denominator = -_denominator;
+    }
+    BigInt divisor = BigInt::gcd(_numerator, _denominator);
+    if (!(divisor == BigInt(1))) {
+        _numerator = _numerator / divisor;
+        _denominator = _denominator / divisor;
+    }
+}
+
+Rational Rational::operator+(const Rational& other) const {
+    if (_denominator == other._denominator) {
+        return Rational(_numerator + other._numerator, _denominator);
+    }
+    return Rational(_numerator * other._denominator + other._numerator * _denominator,
+                    _denominator * other._denominator);
+}
+
+Rational Rational::operator-(const Rational& other) const {
+    if (_denominator == other._denominator) {
+        return Rational(_numerator - other._numerator, _denominator);
+    }
+    return Rational(_numerator * other._denominator - other._numerator * _denominator,
+                    _denominator * other._denominator);
+}
+
+Rational Rational::operator*(const Rational& other) const {
+    return Rational(_numerator * other._numerator, _denominator * other._denominator);
+}
+
+Rational Rational::operator/(const Rational& other) const {
+    if (other._numerator.isZero()) {
+        throw BigInt::DivisionByZeroException();
+    }
+    return Rational(_numerator * other._denominator, _denominator * other._numerator);
+}
+
+const BigInt& Rational::numerator() const {
+    return _numerator;
+}
+
+const BigInt& Rational::denominator() const {
+    return _denominator;
+}
+
+std::string Rational::toString() const {
+    if (_denominator == BigInt(1)) {
+        return _numerator.toString();
+    }
+    return _numerator.toString() + "/" + _denominator.toString();
+}
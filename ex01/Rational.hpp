@@ -0,0 +1,34 @@
+#ifndef RATIONAL_HPP
+#define RATIONAL_HPP
+
+#include <string>
+#include "BigInt.hpp"
+
+// Exact fraction kept in lowest terms with a positive denominator, so
+// equal values always have the same representation.
+class Rational {
+public:
+    Rational();
+    explicit Rational(const BigInt& numerator);
+    Rational(const BigInt& numerator, const BigInt& denominator);
+    Rational(const Rational& other);
+    Rational& operator=(const Rational& other);
+    ~Rational();
+
+    Rational operator+(const Rational& other) const;
+    Rational operator-(const Rational& other) const;
+    Rational operator*(const Rational& other) const;
+    Rational operator/(const Rational& other) const;
+
+    const BigInt& numerator() const;
+    const BigInt& denominator() const;
+    std::string toString() const;
+
+private:
+    BigInt _numerator;
+    BigInt _denominator;
+
+    void normalize();
+};
+
+#endif // RATIONAL_HPP
@@ -0,0 +1,172 @@
+#ifndef STATICRPN_HPP
+#define STATICRPN_HPP
+
+// RPN evaluated by the compiler: StaticRPN<'3', '4', '+', '2', '*'>::value
+// is the constant 14. Tokens are the single characters RPN accepts, one per
+// template argument, up to 32. An invalid token, a missing operand, a
+// leftover operand, a division by zero or an int overflow is a compile
+// error instead of a run-time one.
+namespace StaticRPNDetail {
+
+struct Empty {};
+
+template <int Top, typename Rest>
+struct Node {
+    enum { top = Top };
+    typedef Rest rest;
+};
+
+enum TokenKind { KIND_END, KIND_DIGIT, KIND_OPERATOR, KIND_INVALID };
+
+template <char C>
+struct Kind {
+    enum {
+        value = C == 0 ? KIND_END
+            : (C >= '0' && C <= '9') ? KIND_DIGIT
+            : (C == '+' || C == '-' || C == '*' || C == '/') ? KIND_OPERATOR
+            : KIND_INVALID
+    };
+};
+
+template <int A, int B, char Op>
+struct Compute;
+
+template <int A, int B>
+struct Compute<A, B, '+'> {
+    enum { value = A + B };
+};
+
+template <int A, int B>
+struct Compute<A, B, '-'> {
+    enum { value = A - B };
+};
+
+template <int A, int B>
+struct Compute<A, B, '*'> {
+    enum { value = A * B };
+};
+
+template <int A, int B>
+struct Compute<A, B, '/'> {
+    enum { value = A / B };
+};
+
+// Division by zero: declared but never defined.
+template <int A>
+struct Compute<A, 0, '/'>;
+
+// Only matches a stack holding at least two operands.
+template <typename Stack, char Op>
+struct Binary;
+
+template <int B, int A, typename Rest, char Op>
+struct Binary<Node<B, Node<A, Rest> >, Op> {
+    typedef Node<Compute<A, B, Op>::value, Rest> type;
+};
+
+// KIND_INVALID has no definition.
+template <typename Stack, char C, int K>
+struct Apply;
+
+template <typename Stack, char C>
+struct Apply<Stack, C, KIND_END> {
+    typedef Stack type;
+};
+
+template <typename Stack, char C>
+struct Apply<Stack, C, KIND_DIGIT> {
+    typedef Node<C - '0', Stack> type;
+};
+
+template <typename Stack, char C>
+struct Apply<Stack, C, KIND_OPERATOR> {
+    typedef typename Binary<Stack, C>::type type;
+};
+
+template <typename Stack, char C>
+struct Step {
+    typedef typename Apply<Stack, C, Kind<C>::value>::type type;
+};
+
+// Only matches a stack holding exactly one value.
+template <typename Stack>
+struct Result;
+
+template <int V>
+struct Result<Node<V, Empty> > {
+    enum { value = V };
+};
+
+}
+
+template <char C0 = 0,
+          char C1 = 0,
+          char C2 = 0,
+          char C3 = 0,
+          char C4 = 0,
+          char C5 = 0,
+          char C6 = 0,
+          char C7 = 0,
+          char C8 = 0,
+          char C9 = 0,
+          char C10 = 0,
+          char C11 = 0,
+          char C12 = 0,
+          char C13 = 0,
+          char C14 = 0,
+          char C15 = 0,
+          char C16 = 0,
+          char C17 = 0,
+          char C18 = 0,
+          char C19 = 0,
+          char C20 = 0,
+          char C21 = 0,
+          char C22 = 0,
+          char C23 = 0,
+          char C24 = 0,
+          char C25 = 0,
+          char C26 = 0,
+          char C27 = 0,
+          char C28 = 0,
+          char C29 = 0,
+          char C30 = 0,
+          char C31 = 0>
+struct StaticRPN {
+    typedef StaticRPNDetail::Empty S0;
+    typedef typename StaticRPNDetail::Step<S0, C0>::type S1;
+    typedef typename StaticRPNDetail::Step<S1, C1>::type S2;
+    typedef typename StaticRPNDetail::Step<S2, C2>::type S3;
+    typedef typename StaticRPNDetail::Step<S3, C3>::type S4;
+    typedef typename StaticRPNDetail::Step<S4, C4>::type S5;
+    typedef typename StaticRPNDetail::Step<S5, C5>::type S6;
+    typedef typename StaticRPNDetail::Step<S6, C6>::type S7;
+    typedef typename StaticRPNDetail::Step<S7, C7>::type S8;
+    typedef typename StaticRPNDetail::Step<S8, C8>::type S9;
+    typedef typename StaticRPNDetail::Step<S9, C9>::type S10;
+    typedef typename StaticRPNDetail::Step<S10, C10>::type S11;
+    typedef typename StaticRPNDetail::Step<S11, C11>::type S12;
+    typedef typename StaticRPNDetail::Step<S12, C12>::type S13;
+    typedef typename StaticRPNDetail::Step<S13, C13>::type S14;
+    typedef typename StaticRPNDetail::Step<S14, C14>::type S15;
+    typedef typename StaticRPNDetail::Step<S15, C15>::type S16;
+    typedef typename StaticRPNDetail::Step<S16, C16>::type S17;
+    typedef typename StaticRPNDetail::Step<S17, C17>::type S18;
+    typedef typename StaticRPNDetail::Step<S18, C18>::type S19;
+    typedef typename StaticRPNDetail::Step<S19, C19>::type S20;
+    typedef typename StaticRPNDetail::Step<S20, C20>::type S21;
+    typedef typename StaticRPNDetail::Step<S21, C21>::type S22;
+    typedef typename StaticRPNDetail::Step<S22, C22>::type S23;
+    typedef typename StaticRPNDetail::Step<S23, C23>::type S24;
+    typedef typename StaticRPNDetail::Step<S24, C24>::type S25;
+    typedef typename StaticRPNDetail::Step<S25, C25>::type S26;
+    typedef typename StaticRPNDetail::Step<S26, C26>::type S27;
+    typedef typename StaticRPNDetail::Step<S27, C27>::type S28;
+    typedef typename StaticRPNDetail::Step<S28, C28>::type S29;
+    typedef typename StaticRPNDetail::Step<S29, C29>::type S30;
+    typedef typename StaticRPNDetail::Step<S30, C30>::type S31;
+    typedef typename StaticRPNDetail::Step<S31, C31>::type S32;
+
+    enum { value = StaticRPNDetail::Result<S32>::value };
+};
+
+#endif // STATICRPN_HPP
@@ -0,0 +1,353 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "RPN.hpp"
+#include "EvaluationStats.hpp"
+
+// Benchmarks for the RPN evaluators. Every case runs at least minimumRuns
+// times and until minimumNanos have passed and reports its fastest run,
+// which is the least disturbed by the rest of the machine.
+//
+// stats  RPN::evaluate instantiated with NoStats and with EvaluationStats,
+//        on error-free lines and on lines of which 15% fail, against
+//        Program::compile and run() with no policy at all.
+// batch  "x y * 3 + x y - / 7 * y +" over rows of which 10% divide by
+//        zero: runBatch, run(values) per row, and RPN::evaluate on the
+//        text with the values substituted.
+// exact  run() in int against every runExact back-end, on an expression
+//        that fits in int and on one whose products pass 2^64.
+// optimize  Program::optimized() on patterns repeated 1000 times: the
+//        instruction counts, the cost of optimizing, run() before and
+//        after, and runBatch, which runs the optimized program.
+//
+// ./RPN_bench [section...]
+
+static const long long minimumNanos = 200000000;
+static const size_t minimumRuns = 5;
+
+static long long nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Keeps results alive so the compiler cannot drop the work.
+static volatile long long sink = 0;
+
+// The fastest of the runs of task(), in ns.
+template <typename Task>
+static long long fastest(Task& task) {
+    long long elapsed = 0;
+    long long best = 0;
+    size_t runs = 0;
+    while (runs < minimumRuns || elapsed < minimumNanos) {
+        long long start = nowNanos();
+        task();
+        long long run = nowNanos() - start;
+        elapsed += run;
+        if (runs++ == 0 || run < best) best = run;
+    }
+    return best;
+}
+
+// An expression of operands single digits and operators + - * /, nine
+// tokens long; a failing one ends in a division by zero.
+static std::string randomExpression(bool failing) {
+    static const char operators[] = "+-*/";
+    std::string expression(1, static_cast<char>('1' + std::rand() % 9));
+    for (int i = 0; i < 4; ++i) {
+        expression += ' ';
+        expression += static_cast<char>('1' + std::rand() % 9);
+        expression += ' ';
+        expression += operators[std::rand() % 4];
+    }
+    if (failing) expression += " 0 /";
+    return expression;
+}
+
+template <typename Stats>
+struct EvaluateLines {
+    const std::vector<std::string>* lines;
+    Stats stats;
+
+    void operator()() {
+        long long sum = 0;
+        for (size_t i = 0; i < lines->size(); ++i) {
+            try {
+                sum += RPN::evaluate((*lines)[i], stats);
+            } catch (const RPN::EvaluationException& e) {
+                ++sum;
+            }
+        }
+        sink = sink + sum;
+    }
+};
+
+struct CompileAndRun {
+    const std::vector<std::string>* lines;
+
+    void operator()() {
+        long long sum = 0;
+        for (size_t i = 0; i < lines->size(); ++i) {
+            try {
+                sum += Program::compile((*lines)[i]).run();
+            } catch (const RPN::EvaluationException& e) {
+                ++sum;
+            }
+        }
+        sink = sink + sum;
+    }
+};
+
+static void benchStats() {
+    static const size_t lineCount = 100000;
+    std::printf("RPN::evaluate per stats policy, ns/expression\n");
+    std::printf("%-22s %14s %14s\n", "policy", "error-free", "15% errors");
+
+    std::vector<std::string> clean;
+    std::vector<std::string> mixed;
+    std::srand(42);
+    for (size_t i = 0; i < lineCount; ++i) {
+        clean.push_back(randomExpression(false));
+        mixed.push_back(randomExpression(std::rand() % 100 < 15));
+    }
+
+    CompileAndRun plain;
+    plain.lines = &clean;
+    double plainClean = static_cast<double>(fastest(plain)) / lineCount;
+    plain.lines = &mixed;
+    double plainMixed = static_cast<double>(fastest(plain)) / lineCount;
+    std::printf("%-22s %14.1f %14.1f\n", "compile + run", plainClean, plainMixed);
+
+    EvaluateLines<NoStats> none;
+    EvaluateLines<EvaluationStats> counting;
+    double noneClean, noneMixed, countingClean, countingMixed;
+    none.lines = &clean;
+    noneClean = static_cast<double>(fastest(none)) / lineCount;
+    none.lines = &mixed;
+    noneMixed = static_cast<double>(fastest(none)) / lineCount;
+    counting.lines = &clean;
+    countingClean = static_cast<double>(fastest(counting)) / lineCount;
+    counting.lines = &mixed;
+    countingMixed = static_cast<double>(fastest(counting)) / lineCount;
+    std::printf("%-22s %14.1f %14.1f\n", "NoStats", noneClean, noneMixed);
+    std::printf("%-22s %14.1f %14.1f\n", "EvaluationStats", countingClean, countingMixed);
+    std::printf("\n");
+}
+
+static const char* const batchExpression = "x y * 3 + x y - / 7 * y +";
+
+struct RunBatch {
+    const Program* program;
+    const int* const* columns;
+    size_t rows;
+    std::vector<int>* results;
+    std::vector<unsigned char>* status;
+
+    void operator()() {
+        program->runBatch(columns, rows, &(*results)[0], &(*status)[0]);
+        sink = sink + (*results)[rows / 2];
+    }
+};
+
+struct RunRows {
+    const Program* program;
+    const int* const* columns;
+    size_t rows;
+
+    void operator()() {
+        long long sum = 0;
+        for (size_t r = 0; r < rows; ++r) {
+            int variables[2] = { columns[0][r], columns[1][r] };
+            try {
+                sum += program->run(variables);
+            } catch (const RPN::EvaluationException& e) {
+                ++sum;
+            }
+        }
+        sink = sink + sum;
+    }
+};
+
+static void benchBatch() {
+    static const size_t rows = 1000000;
+    static const size_t textRows = 100000;
+    std::printf("%s, Mrows/s\n", batchExpression);
+
+    std::vector<int> x(rows);
+    std::vector<int> y(rows);
+    std::srand(42);
+    for (size_t r = 0; r < rows; ++r) {
+        x[r] = std::rand() % 1000;
+        y[r] = std::rand() % 10 == 0 ? x[r] : std::rand() % 1000;
+    }
+    const int* columns[2] = { &x[0], &y[0] };
+    Program program = Program::compile(batchExpression, "xy");
+
+    std::vector<int> results(rows);
+    std::vector<unsigned char> status(rows);
+    RunBatch batch;
+    batch.program = &program;
+    batch.columns = columns;
+    batch.rows = rows;
+    batch.results = &results;
+    batch.status = &status;
+    std::printf("%-22s %10.2f\n", "runBatch", rows / (static_cast<double>(fastest(batch)) / 1000.0));
+
+    RunRows scalar;
+    scalar.program = &program;
+    scalar.columns = columns;
+    scalar.rows = rows;
+    std::printf("%-22s %10.2f\n", "run(values)", rows / (static_cast<double>(fastest(scalar)) / 1000.0));
+
+    // The substituted text is built up front; only evaluation is timed.
+    std::vector<std::string> lines;
+    for (size_t r = 0; r < textRows; ++r) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "%d %d * 3 + %d %d - / 7 * %d +", x[r], y[r], x[r], y[r], y[r]);
+        lines.push_back(line);
+    }
+    EvaluateLines<NoStats> text;
+    text.lines = &lines;
+    std::printf("%-22s %10.2f\n", "evaluate() on text", textRows / (static_cast<double>(fastest(text)) / 1000.0));
+    std::printf("\n");
+}
+
+struct RunExact {
+    const Program* program;
+    Program::Backend backend;
+    bool native;
+    size_t repetitions;
+
+    void operator()() {
+        long long sum = 0;
+        for (size_t i = 0; i < repetitions; ++i) {
+            sum += native ? program->run() : static_cast<long long>(program->runExact(backend).size());
+        }
+        sink = sink + sum;
+    }
+};
+
+static void benchExact() {
+    static const size_t repetitions = 20000;
+    static const char* const backendNames[] = { "int run()", "checked64", "int128", "bigint", "rational" };
+    static const Program::Backend backends[] = {
+        Program::BACKEND_CHECKED64, Program::BACKEND_CHECKED64, Program::BACKEND_INT128,
+        Program::BACKEND_BIGINT, Program::BACKEND_RATIONAL
+    };
+    Program fits = Program::compile("3 4 + 2 * 7 - 5 * 9 + 2 / 8 * 6 - 4 + 3 *");
+    Program overflows = Program::compile("999999 999999 * 999999 * 999999 * 999999 * 7 - 3 / 999999 * 5 +");
+    std::printf("Exact back-ends, ns/evaluation including the result text\n");
+    std::printf("%-22s %14s %14s\n", "back-end", "fits in int", "past 2^64");
+    for (size_t b = 0; b < 5; ++b) {
+        RunExact task;
+        task.backend = backends[b];
+        task.native = b == 0;
+        task.repetitions = repetitions;
+        task.program = &fits;
+        double small = static_cast<double>(fastest(task)) / repetitions;
+        if (task.native) {
+            std::printf("%-22s %14.1f %14s\n", backendNames[b], small, "-");
+            continue;
+        }
+        task.program = &overflows;
+        double large = static_cast<double>(fastest(task)) / repetitions;
+        std::printf("%-22s %14.1f %14.1f\n", backendNames[b], small, large);
+    }
+    std::printf("\n");
+}
+
+struct Optimize {
+    const Program* program;
+
+    void operator()() {
+        sink = sink + static_cast<long long>(program->optimized().size());
+    }
+};
+
+struct RunOnce {
+    const Program* program;
+    const int* variables;
+
+    void operator()() {
+        sink = sink + program->run(variables);
+    }
+};
+
+static void benchOptimize() {
+    static const size_t repetitions = 1000;
+    static const size_t rows = 100000;
+    static const char* const patterns[] = { " 3 4 + 2 * +", " 3 4 + 2 * x y * + +", " x 0 + 1 * y 1 * - 0 + 1 * +", NULL };
+    std::printf("Program::optimized(), each pattern after x, %lu times\n", static_cast<unsigned long>(repetitions));
+    std::printf("%-30s %16s %12s %18s %14s\n", "pattern", "instructions", "optimize", "run()", "runBatch");
+
+    std::vector<int> x(rows);
+    std::vector<int> y(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        x[r] = static_cast<int>(r % 7);
+        y[r] = static_cast<int>(r % 5);
+    }
+    const int* columns[2] = { &x[0], &y[0] };
+    int variables[2] = { 3, 2 };
+    std::vector<int> results(rows);
+    std::vector<unsigned char> status(rows);
+
+    for (size_t p = 0; patterns[p]; ++p) {
+        std::string expression = "x";
+        for (size_t i = 0; i < repetitions; ++i) {
+            expression += patterns[p];
+        }
+        Program original = Program::compile(expression, "xy");
+        Program optimized = original.optimized();
+
+        Optimize optimize;
+        optimize.program = &original;
+        RunOnce before;
+        before.program = &original;
+        before.variables = variables;
+        RunOnce after = before;
+        after.program = &optimized;
+        RunBatch batch;
+        batch.program = &original;
+        batch.columns = columns;
+        batch.rows = rows;
+        batch.results = &results;
+        batch.status = &status;
+
+        char counts[32];
+        char runs[32];
+        std::snprintf(counts, sizeof(counts), "%lu -> %lu", static_cast<unsigned long>(original.size()),
+                      static_cast<unsigned long>(optimized.size()));
+        std::snprintf(runs, sizeof(runs), "%.1f -> %.1f us", fastest(before) / 1000.0, fastest(after) / 1000.0);
+        double optimizeMicros = fastest(optimize) / 1000.0;
+        std::printf("%-30s %16s %9.1f us %18s %11.1f ms\n", patterns[p] + 1, counts, optimizeMicros, runs,
+                    fastest(batch) / 1000000.0);
+    }
+    std::printf("\n");
+}
+
+struct Section {
+    const char* name;
+    void (*run)();
+};
+
+static const Section sections[] = {
+    { "stats", &benchStats },
+    { "batch", &benchBatch },
+    { "exact", &benchExact },
+    { "optimize", &benchOptimize },
+    { NULL, NULL }
+};
+
+int main(int argc, char** argv) {
+    for (size_t s = 0; sections[s].name; ++s) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == sections[s].name) selected = true;
+        }
+        if (selected) sections[s].run();
+    }
+    return 0;
+}
@@ -1,19 +1,204 @@
 #include "RPN.hpp"
+#include "RPNStream.hpp"
+#include "BatchRunner.hpp"
+#include "EvaluationStats.hpp"
 #include <iostream>
 #include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+static bool parseBackend(const std::string& name, Program::Backend& backend) {
+    if (name == "checked64") backend = Program::BACKEND_CHECKED64;
+    else if (name == "int128") backend = Program::BACKEND_INT128;
+    else if (name == "bigint") backend = Program::BACKEND_BIGINT;
+    else if (name == "rational") backend = Program::BACKEND_RATIONAL;
+    else return false;
+    return true;
+}
+
+static bool readAll(int fd, std::vector<char>& data) {
+    char buffer[1 << 16];
+    while (true) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n == 0) return true;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.insert(data.end(), buffer, buffer + n);
+    }
+}
+
+// Shortest %g text, from 15 significant digits up, that reads back as the
+// same double.
+static std::string formatReal(double value) {
+    char buffer[32];
+    for (int precision = 15; precision < 17; ++precision) {
+        std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (std::strtod(buffer, NULL) == value) return buffer;
+    }
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    return buffer;
+}
+
+// ./RPN --stream [file] evaluates the whole input as one expression;
+// ./RPN --lines [-j N] [file] evaluates one expression per line, on N
+// threads when -j is given. Both read stdin when no file is given.
+static int runStream(const std::string& mode, const char* filename, int threadCount) {
+    int fd = 0;
+    if (filename) {
+        fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: could not open file." << std::endl;
+            return 1;
+        }
+    }
+
+    int status = 0;
+    RPNStream stream(fd);
+    try {
+        if (threadCount > 0) {
+            std::vector<char> data;
+            if (!readAll(fd, data)) {
+                std::cerr << "Error: could not read input." << std::endl;
+                status = 1;
+            } else {
+                BatchRunner runner(data.empty() ? NULL : &data[0], data.size(), threadCount);
+                status = runner.run(1) ? 1 : 0;
+            }
+        } else if (mode == "--lines") {
+            status = stream.evaluateLines(1) ? 1 : 0;
+        } else {
+            std::cout << stream.evaluateAll() << std::endl;
+        }
+    } catch (const RPN::EvaluationException& e) {
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+    if (filename) {
+        close(fd);
+    }
+    return status;
+}
+
+// ./RPN --stats [file] evaluates one expression per line, like --lines,
+// through the instrumented evaluator and then reports its counters on
+// stderr, so stdout stays the same as with --lines.
+static int runStats(const char* filename) {
+    int fd = 0;
+    if (filename) {
+        fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: could not open file." << std::endl;
+            return 1;
+        }
+    }
+    std::vector<char> data;
+    bool complete = readAll(fd, data);
+    if (filename) {
+        close(fd);
+    }
+    if (!complete) {
+        std::cerr << "Error: could not read input." << std::endl;
+        return 1;
+    }
+
+    EvaluationStats stats;
+    std::string out;
+    size_t failures = 0;
+    const char* p = data.empty() ? NULL : &data[0];
+    const char* end = p + data.size();
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (eol == NULL) {
+            // An unterminated last line that holds nothing is not a line.
+            eol = end;
+            const char* q = p;
+            while (q < end && Lexer::isSpace(*q)) ++q;
+            if (q == end) break;
+        }
+        try {
+            RPNStream::appendInteger(out, RPN::evaluate(std::string(p, eol), stats));
+        } catch (const RPN::EvaluationException& e) {
+            out += e.what();
+            ++failures;
+        }
+        out += '\n';
+        if (out.size() >= (1 << 16)) {
+            RPNStream::writeAll(1, out);
+            out.clear();
+        }
+        p = eol + 1;
+    }
+    RPNStream::writeAll(1, out);
+    std::cerr << stats.report();
+    return failures ? 1 : 0;
+}
 
 int main(int argc, char **argv) {
+    if (argc >= 2 && argc <= 5 && std::string(argv[1]) == "--lines") {
+        int threadCount = 0;
+        int next = 2;
+        if (argc >= 4 && std::string(argv[2]) == "-j") {
+            char* endPtr;
+            long value = std::strtol(argv[3], &endPtr, 10);
+            if (*endPtr != '\0' || endPtr == argv[3] || value < 1 || value > 1024) {
+                std::cerr << "Error: invalid thread count." << std::endl;
+                return 1;
+            }
+            threadCount = static_cast<int>(value);
+            next = 4;
+        }
+        if (argc - next <= 1) {
+            return runStream(argv[1], next < argc ? argv[next] : NULL, threadCount);
+        }
+    }
+    if ((argc == 2 || argc == 3) && std::string(argv[1]) == "--stats") {
+        return runStats(argc == 3 ? argv[2] : NULL);
+    }
+    if ((argc == 2 || argc == 3) && std::string(argv[1]) == "--stream") {
+        return runStream(argv[1], argc == 3 ? argv[2] : NULL, 0);
+    }
+
+    // ./RPN --backend <name> "<expression>" evaluates exactly instead of in int.
+    Program::Backend backend = Program::BACKEND_CHECKED64;
+    bool exact = false;
+    if (argc == 4 && std::string(argv[1]) == "--backend" && parseBackend(argv[2], backend)) {
+        exact = true;
+        argv += 2;
+        argc -= 2;
+    }
+
     if (argc != 2) {
         std::cerr << "Error: Invalid number of arguments." << std::endl;
         std::cerr << "Usage: ./RPN \"<expression>\"" << std::endl;
+        std::cerr << "       ./RPN --backend checked64|int128|bigint|rational \"<expression>\"" << std::endl;
+        std::cerr << "       ./RPN --stream [file]" << std::endl;
+        std::cerr << "       ./RPN --lines [-j N] [file]" << std::endl;
+        std::cerr << "       ./RPN --stats [file]" << std::endl;
         return 1;
     }
 
     std::string expression = argv[1];
 
     try {
-        int result = RPN::evaluate(expression);
-        std::cout << result << std::endl;
+        if (exact) {
+            std::cout << RPN::compile(expression).runExact(backend) << std::endl;
+        } else {
+            // A literal that is not an int, such as 2.5, switches the
+            // evaluation to double.
+            Program program = RPN::compile(expression);
+            if (program.integerOnly()) {
+                std::cout << program.run() << std::endl;
+            } else {
+                std::cout << formatReal(program.evaluateAs<double>()) << std::endl;
+            }
+        }
     } catch (const RPN::EvaluationException& e) {
         std::cerr << e.what() << std::endl;
         return 1;
@@ -0,0 +1,242 @@
+#include <climits>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "RPN.hpp"
+#include "Program.hpp"
+#include "Lexer.hpp"
+#include "Literal.hpp"
+#include "StaticRPN.hpp"
+
+// Regression tests for the evaluators; make test builds and runs them.
+// Each check prints what failed, and the exit status is the number of
+// failures.
+
+static int failures = 0;
+
+// Compile-time checks: the array size is negative, and the build fails,
+// when StaticRPN disagrees.
+typedef char staticSum[StaticRPN<'3', '4', '+', '2', '*'>::value == 14 ? 1 : -1];
+typedef char staticOrder[StaticRPN<'8', '9', '*', '9', '-', '9', '-', '9', '-', '4', '-', '1', '+'>::value == 42 ? 1 : -1];
+typedef char staticDivision[StaticRPN<'7', '2', '/', '1', '3', '-', '*'>::value == -6 ? 1 : -1];
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// The error an evaluation raises, or "" when it succeeds.
+static std::string errorOf(const std::string& expression) {
+    try {
+        RPN::evaluate(expression);
+    } catch (const RPN::EvaluationException& e) {
+        return e.what();
+    }
+    return "";
+}
+
+static std::string stepErrorOf(const std::string& expression) {
+    std::vector<int> stack;
+    Lexer lexer(expression.data(), expression.data() + expression.size());
+    Lexer::Token token;
+    try {
+        while (lexer.next(token)) {
+            RPN::step(token, stack);
+        }
+        RPN::result(stack);
+    } catch (const RPN::EvaluationException& e) {
+        return e.what();
+    }
+    return "";
+}
+
+template <typename T>
+static std::string errorAs(const Program& program, const T* variables) {
+    try {
+        program.evaluateAs<T>(variables);
+    } catch (const RPN::EvaluationException& e) {
+        return e.what();
+    }
+    return "";
+}
+
+static void testDivisionOverflow() {
+    check(errorOf("-2147483648 -1 /") == "Error: Division overflow", "INT_MIN / -1 in evaluate");
+    check(stepErrorOf("-2147483648 -1 /") == "Error: Division overflow", "INT_MIN / -1 in step");
+    check(RPN::evaluate("-2147483648 1 /") == INT_MIN, "INT_MIN / 1");
+    check(RPN::evaluate("-2147483647 -1 /") == INT_MAX, "-INT_MAX / -1");
+
+    Program program = Program::compile("x y /", "xy");
+    long long wide[2] = { LLONG_MIN, -1 };
+    check(errorAs(program, wide) == "Error: Division overflow", "LLONG_MIN / -1 in evaluateAs<long long>");
+    int narrow[2] = { INT_MIN, -1 };
+    check(errorAs(program, narrow) == "Error: Division overflow", "INT_MIN / -1 in evaluateAs<int>");
+    double real[2] = { -1e300, -1 };
+    check(errorAs(program, real) == "", "double division by -1");
+}
+
+static void testBatchDivision() {
+    Program program = Program::compile("x y /", "xy");
+    const size_t rows = 20;
+    std::vector<int> x(rows, 7);
+    std::vector<int> y(rows, 2);
+    x[3] = INT_MIN;
+    y[3] = -1;
+    y[17] = 0;
+    x[18] = INT_MIN;
+    y[18] = 1;
+    const int* columns[2] = { &x[0], &y[0] };
+    std::vector<int> results(rows);
+    std::vector<unsigned char> status(rows);
+    program.runBatch(columns, rows, &results[0], &status[0]);
+    for (size_t r = 0; r < rows; ++r) {
+        if (r == 3) {
+            check(status[r] == Program::ROW_DIVISION_OVERFLOW && results[r] == 0, "batch INT_MIN / -1 row");
+        } else if (r == 17) {
+            check(status[r] == Program::ROW_DIVISION_BY_ZERO && results[r] == 0, "batch zero divisor row");
+        } else if (r == 18) {
+            check(status[r] == Program::ROW_OK && results[r] == INT_MIN, "batch INT_MIN / 1 row");
+        } else {
+            check(status[r] == Program::ROW_OK && results[r] == 3, "batch rows around a failed one");
+        }
+    }
+}
+
+static std::string runErrorOf(const Program& program) {
+    try {
+        program.run();
+    } catch (const RPN::EvaluationException& e) {
+        return e.what();
+    }
+    return "";
+}
+
+static std::string exactErrorOf(const Program& program, Program::Backend backend) {
+    try {
+        program.runExact(backend);
+    } catch (const RPN::EvaluationException& e) {
+        return e.what();
+    }
+    return "";
+}
+
+// The optimized program must fail with the same error as the original,
+// in int and in the exact back-ends.
+static void checkSameError(const std::string& expression) {
+    Program original = Program::compile(expression);
+    Program optimized = original.optimized();
+    check(runErrorOf(optimized) == runErrorOf(original), "optimized int error for " + expression);
+    check(exactErrorOf(optimized, Program::BACKEND_CHECKED64) == exactErrorOf(original, Program::BACKEND_CHECKED64),
+          "optimized checked64 error for " + expression);
+}
+
+static void testOptimizedErrorOrder() {
+    check(runErrorOf(Program::compile("1 0 / 2.5 + 2.5 *")) == "Error: Division by zero", "source error order");
+    checkSameError("1 0 / 2.5 + 2.5 *");
+    checkSameError("2.5 1 0 / *");
+    checkSameError("1 0 / 2.5 * 2.5 1 0 / * +");
+    checkSameError("3 4 + 4 3 + *");
+}
+
+// runBatch runs the optimized program; every row must match run() on the
+// unoptimized one, including rows that fail.
+static void testBatchMatchesRun() {
+    const char* expressions[] = {
+        "x y + x y + *", "x 0 * y /", "y x / x y / +", "x 1 * 0 + y 1 * -", "x y - x y - x y - * *", NULL
+    };
+    const size_t rows = 37;
+    std::vector<int> x(rows);
+    std::vector<int> y(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        x[r] = static_cast<int>(r) - 18;
+        y[r] = static_cast<int>(r % 5) - 2;
+    }
+    x[4] = INT_MIN;
+    y[4] = -1;
+    const int* columns[2] = { &x[0], &y[0] };
+    for (size_t e = 0; expressions[e]; ++e) {
+        Program program = Program::compile(expressions[e], "xy");
+        std::vector<int> results(rows);
+        std::vector<unsigned char> status(rows);
+        program.runBatch(columns, rows, &results[0], &status[0]);
+        for (size_t r = 0; r < rows; ++r) {
+            int variables[2] = { x[r], y[r] };
+            std::string error;
+            int expected = 0;
+            try {
+                expected = program.run(variables);
+            } catch (const RPN::EvaluationException& ex) {
+                error = ex.what();
+            }
+            unsigned char expectedStatus = error.empty() ? Program::ROW_OK
+                : error == "Error: Division by zero" ? Program::ROW_DIVISION_BY_ZERO : Program::ROW_DIVISION_OVERFLOW;
+            check(status[r] == expectedStatus && results[r] == expected,
+                  std::string("batch row matches run() for ") + expressions[e]);
+        }
+    }
+}
+
+// A literal that is not an int and a division by -1 can both fail, so
+// the optimizer must neither drop them nor move them.
+static void testImpureNodesKept() {
+    checkSameError("2.5 0 *");
+    checkSameError("0 2.5 *");
+    checkSameError("2.5 2.5 -");
+    checkSameError("1 0 / 2.5 2.5 + *");
+
+    Program program = Program::compile("x -1 / 0 *", "x");
+    int variables[1] = { INT_MIN };
+    std::string error;
+    try {
+        program.optimized().run(variables);
+    } catch (const RPN::EvaluationException& e) {
+        error = e.what();
+    }
+    check(error == "Error: Division overflow", "x / -1 is kept under * 0");
+}
+
+// BigInt and Rational throw their own exception; runExact reports it as
+// the error every other evaluator raises.
+static void testExactDivisionByZero() {
+    static const Program::Backend backends[] = {
+        Program::BACKEND_CHECKED64, Program::BACKEND_INT128, Program::BACKEND_BIGINT, Program::BACKEND_RATIONAL
+    };
+    Program direct = Program::compile("7 0 /");
+    Program overflowed = Program::compile("999999 999999 * 999999 * 999999 * 999999 * 2 2 - /");
+    for (size_t b = 0; b < 4; ++b) {
+        check(exactErrorOf(direct, backends[b]) == "Error: Division by zero", "exact division by zero");
+        check(exactErrorOf(overflowed, backends[b]) == "Error: Division by zero", "exact division by zero past 2^64");
+    }
+}
+
+// Zero takes any exponent; the exact back-ends must not expand it.
+static void testZeroWithHugeExponent() {
+    check(Program::compile("0e999999999 1 +").runExact(Program::BACKEND_BIGINT) == "1", "0e999999999 in bigint");
+    check(Program::compile("0e99999999999 1 +").runExact(Program::BACKEND_RATIONAL) == "1", "0e99999999999 in rational");
+    check(Literal::exact("-0.0e-99999999999", 17).numerator().isZero(), "negative zero with a huge negative exponent");
+}
+
+// The interpreter must agree with the compile-time evaluator.
+static void testStaticRPN() {
+    check(RPN::evaluate("3 4 + 2 *") == StaticRPN<'3', '4', '+', '2', '*'>::value, "3 4 + 2 *");
+    check(RPN::evaluate("8 9 * 9 - 9 - 9 - 4 - 1 +")
+              == StaticRPN<'8', '9', '*', '9', '-', '9', '-', '9', '-', '4', '-', '1', '+'>::value,
+          "8 9 * 9 - 9 - 9 - 4 - 1 +");
+    check(RPN::evaluate("7 2 / 1 3 - *") == StaticRPN<'7', '2', '/', '1', '3', '-', '*'>::value, "7 2 / 1 3 - *");
+    check(RPN::evaluate("9") == StaticRPN<'9'>::value, "9");
+}
+
+int main() {
+    testZeroWithHugeExponent();
+    testExactDivisionByZero();
+    testStaticRPN();
+    testImpureNodesKept();
+    testBatchMatchesRun();
+    testOptimizedErrorOrder();
+    testDivisionOverflow();
+    testBatchDivision();
+    if (failures == 0) std::cout << "All tests passed" << std::endl;
+    return failures;
+}
@@ -0,0 +1,54 @@
+#ifndef KEYEDMERGEINSERTION_HPP
+#define KEYEDMERGEINSERTION_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "MergeInsertion.hpp"
+
+// Merge-insertion for large records: the keys are extracted once into a
+// dense array, MergeInsertion sorts that array into a permutation, and
+// the permutation is applied to the records in place. Each record is then
+// copied once, plus one temporary per cycle, instead of being read at
+// every comparison and swapped into place. KeyOf is a function object
+// with a key_type typedef that returns the key of a record; Compare
+// orders keys.
+template <typename Container, typename KeyOf,
+          typename Compare = std::less<typename KeyOf::key_type> >
+class KeyedMergeInsertion {
+public:
+    typedef typename Container::value_type value_type;
+    typedef typename KeyOf::key_type key_type;
+
+    KeyedMergeInsertion() : _keyOf(), _compare() {}
+    explicit KeyedMergeInsertion(const KeyOf& keyOf, const Compare& compare = Compare())
+        : _keyOf(keyOf), _compare(compare) {}
+    KeyedMergeInsertion(const KeyedMergeInsertion& other)
+        : _keyOf(other._keyOf), _compare(other._compare) {}
+    KeyedMergeInsertion& operator=(const KeyedMergeInsertion& other) {
+        if (this != &other) {
+            _keyOf = other._keyOf;
+            _compare = other._compare;
+        }
+        return *this;
+    }
+    ~KeyedMergeInsertion() {}
+
+    void sort(Container& items) {
+        std::vector<key_type> keys;
+        keys.reserve(items.size());
+        for (size_t i = 0; i < items.size(); ++i) {
+            keys.push_back(_keyOf(items[i]));
+        }
+        std::vector<size_t> permutation;
+        MergeInsertion<std::vector<key_type>, Compare> sorter(_compare);
+        sorter.order(keys, permutation);
+        applyPermutationByCopy(items, permutation);
+    }
+
+private:
+    KeyOf _keyOf;
+    Compare _compare;
+};
+
+#endif // KEYEDMERGEINSERTION_HPP
@@ -0,0 +1,154 @@
+#include "MainChain.hpp"
+#include <algorithm>
+
+MainChain::MainChain() : _blockCapacity(defaultBlockCapacity), _size(0), _topStep(0) {
+    std::vector<size_t> empty;
+    assign(empty);
+}
+
+// Blocks smaller than the default only make sense in tests, which use them
+// to split blocks on short chains; at least two entries are needed.
+MainChain::MainChain(size_t blockCapacity)
+    : _blockCapacity(blockCapacity < 2 ? 2 : blockCapacity), _size(0), _topStep(0) {
+    std::vector<size_t> empty;
+    assign(empty);
+}
+
+MainChain::MainChain(const MainChain& other)
+    : _blockCapacity(other._blockCapacity), _items(other._items), _sizes(other._sizes), _order(other._order),
+      _tree(other._tree), _size(other._size), _topStep(other._topStep) {}
+
+MainChain& MainChain::operator=(const MainChain& other) {
+    if (this != &other) {
+        _blockCapacity = other._blockCapacity;
+        _items = other._items;
+        _sizes = other._sizes;
+        _order = other._order;
+        _tree = other._tree;
+        _size = other._size;
+        _topStep = other._topStep;
+    }
+    return *this;
+}
+
+MainChain::~MainChain() {}
+
+// Replaces the chain with items, half filling each block so that the
+// first insertions do not split every block at once.
+void MainChain::assign(const std::vector<size_t>& items) {
+    size_t fill = _blockCapacity / 2;
+    size_t blocks = items.empty() ? 1 : (items.size() + fill - 1) / fill;
+    _items.assign(blocks * _blockCapacity, 0);
+    _sizes.assign(blocks, 0);
+    _order.resize(blocks);
+    for (size_t block = 0; block < blocks; ++block) {
+        size_t first = block * fill;
+        size_t last = std::min(first + fill, items.size());
+        std::copy(items.begin() + first, items.begin() + last, _items.begin() + block * _blockCapacity);
+        _sizes[block] = last - first;
+        _order[block] = block;
+    }
+    _size = items.size();
+    rebuildIndex();
+}
+
+// Rebuilds the Fenwick tree over the block sizes in chain order, in
+// linear time.
+void MainChain::rebuildIndex() {
+    size_t blocks = _order.size();
+    _tree.assign(blocks + 1, 0);
+    for (size_t i = 1; i <= blocks; ++i) {
+        _tree[i] += _sizes[_order[i - 1]];
+        size_t parent = i + (i & (0 - i));
+        if (parent <= blocks) _tree[parent] += _tree[i];
+    }
+    _topStep = 1;
+    while (_topStep * 2 <= blocks) _topStep *= 2;
+}
+
+// Finds the block (in chain order) holding rank and the offset within it.
+// rank may be size(), which is the end of the last block.
+void MainChain::locate(size_t rank, size_t& block, size_t& offset) const {
+    size_t blocks = _order.size();
+    if (rank >= _size) {
+        block = blocks - 1;
+        offset = _sizes[_order[block]];
+        return;
+    }
+    size_t position = 0;
+    for (size_t step = _topStep; step != 0; step /= 2) {
+        if (position + step <= blocks && _tree[position + step] <= rank) {
+            position += step;
+            rank -= _tree[position];
+        }
+    }
+    block = position;
+    offset = rank;
+}
+
+// Moves the upper half of a full block into a new block placed right
+// after it in chain order.
+void MainChain::split(size_t block) {
+    size_t full = _order[block];
+    size_t added = _sizes.size();
+    size_t half = _blockCapacity / 2;
+    _items.resize(_items.size() + _blockCapacity);
+    std::copy(_items.begin() + full * _blockCapacity + half, _items.begin() + (full + 1) * _blockCapacity,
+              _items.begin() + added * _blockCapacity);
+    _sizes[full] = half;
+    _sizes.push_back(_blockCapacity - half);
+    _order.insert(_order.begin() + block + 1, added);
+    rebuildIndex();
+}
+
+void MainChain::insert(size_t rank, size_t item) {
+    size_t block;
+    size_t offset;
+    locate(rank, block, offset);
+    if (_sizes[_order[block]] == _blockCapacity) {
+        split(block);
+        locate(rank, block, offset);
+    }
+    size_t physical = _order[block];
+    std::vector<size_t>::iterator first = _items.begin() + physical * _blockCapacity;
+    std::copy_backward(first + offset, first + _sizes[physical], first + _sizes[physical] + 1);
+    first[offset] = item;
+    ++_sizes[physical];
+    for (size_t i = block + 1; i < _tree.size(); i += i & (0 - i)) {
+        ++_tree[i];
+    }
+    ++_size;
+}
+
+size_t MainChain::blockCapacity() const {
+    return _blockCapacity;
+}
+
+size_t MainChain::size() const {
+    return _size;
+}
+
+size_t MainChain::operator[](size_t rank) const {
+    size_t block;
+    size_t offset;
+    locate(rank, block, offset);
+    return _items[_order[block] * _blockCapacity + offset];
+}
+
+const size_t* MainChain::run(size_t rank, size_t& count) const {
+    size_t block;
+    size_t offset;
+    locate(rank, block, offset);
+    size_t physical = _order[block];
+    count = _sizes[physical] - offset;
+    return &_items[physical * _blockCapacity + offset];
+}
+
+void MainChain::materialize(std::vector<size_t>& out) const {
+    out.clear();
+    out.reserve(_size);
+    for (size_t block = 0; block < _order.size(); ++block) {
+        std::vector<size_t>::const_iterator first = _items.begin() + _order[block] * _blockCapacity;
+        out.insert(out.end(), first, first + _sizes[_order[block]]);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef MAINCHAIN_HPP
+#define MAINCHAIN_HPP
+
+#include <cstddef>
+#include <vector>
+
+// The main chain of merge-insertion: a sequence of element indices with
+// insertion at any rank. Elements live in fixed-size blocks, kept about
+// half full, and a Fenwick tree over the block sizes in chain order finds
+// the block holding a rank in O(log n); an insertion moves at most one
+// block's worth of entries. A full block is split in two, leaving every
+// other block's entries in place, but the new block shifts the later ones
+// in chain order, so the order and the tree are rebuilt in O(n / B) for
+// blocks of B entries. A split follows at least B / 2 insertions into the
+// block, so an insertion costs O(log n + B + n / B^2) amortized.
+class MainChain {
+public:
+    MainChain();
+    explicit MainChain(size_t blockCapacity);
+    MainChain(const MainChain& other);
+    MainChain& operator=(const MainChain& other);
+    ~MainChain();
+
+    void assign(const std::vector<size_t>& items);
+    void insert(size_t rank, size_t item);
+
+    size_t size() const;
+    size_t operator[](size_t rank) const;
+    // The entries from rank to the end of its block; count receives how
+    // many there are.
+    const size_t* run(size_t rank, size_t& count) const;
+
+    void materialize(std::vector<size_t>& out) const;
+
+    size_t blockCapacity() const;
+
+    static const size_t defaultBlockCapacity = 512;
+
+private:
+    void locate(size_t rank, size_t& block, size_t& offset) const;
+    void split(size_t block);
+    void rebuildIndex();
+
+    // Blocks are stored one after another in _items by physical number;
+    // _order lists them in chain order and _tree indexes their sizes in
+    // that order.
+    size_t _blockCapacity;
+    std::vector<size_t> _items;
+    std::vector<size_t> _sizes;
+    std::vector<size_t> _order;
+    std::vector<size_t> _tree;
+    size_t _size;
+    size_t _topStep;
+};
+
+#endif // MAINCHAIN_HPP
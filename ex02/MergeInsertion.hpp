@@ -0,0 +1,274 @@
+#ifndef MERGEINSERTION_HPP
+#define MERGEINSERTION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "MainChain.hpp"
+
+// How the recursion below the first level refers to an element of type
+// T: a copy when T is no bigger than two pointers, so that small keys are
+// compared in a dense array, and a pointer into the caller's container
+// otherwise, so that a large element is never copied. get reads either.
+template <typename T, bool Indirect = (sizeof(T) > 2 * sizeof(void*))>
+struct MergeInsertionHandle {
+    typedef T type;
+
+    static const T& make(const T& value) { return value; }
+    static const T& get(const T& value) { return value; }
+};
+
+template <typename T>
+struct MergeInsertionHandle<T, true> {
+    typedef const T* type;
+
+    static type make(const T& value) { return &value; }
+    static const T& get(const T& value) { return value; }
+    static const T& get(const T* handle) { return *handle; }
+};
+
+// The elements first to last - 1 of a container, indexed from 0, for
+// sorting part of it.
+template <typename Container>
+struct MergeInsertionRange {
+    const Container* items;
+    size_t first;
+    size_t last;
+
+    size_t size() const { return last - first; }
+    const typename Container::value_type& operator[](size_t i) const { return (*items)[first + i]; }
+};
+
+// Puts items[permutation[i]] at position i for every i, where
+// permutation[i] is the original position of the i-th smallest element.
+// Each cycle is followed by pulling the element for a position from its
+// source with swap; placed positions are marked by pointing them at
+// themselves, so permutation ends as the identity.
+template <typename Container>
+void applyPermutation(Container& items, std::vector<size_t>& permutation) {
+    for (size_t start = 0; start < permutation.size(); ++start) {
+        size_t position = start;
+        while (permutation[position] != start) {
+            size_t source = permutation[position];
+            using std::swap;
+            swap(items[position], items[source]);
+            permutation[position] = position;
+            position = source;
+        }
+        permutation[position] = position;
+    }
+}
+
+// The same by copying: each cycle is rotated through one held element, so
+// every element is copied once, plus one temporary per cycle, where swap
+// would take three moves. For records whose swap is a full copy.
+template <typename Container>
+void applyPermutationByCopy(Container& items, std::vector<size_t>& permutation) {
+    for (size_t start = 0; start < permutation.size(); ++start) {
+        if (permutation[start] == start) continue;
+        typename Container::value_type held = items[start];
+        size_t position = start;
+        while (permutation[position] != start) {
+            size_t source = permutation[position];
+            items[position] = items[source];
+            permutation[position] = position;
+            position = source;
+        }
+        items[position] = held;
+        permutation[position] = position;
+    }
+}
+
+// Merge-insertion (Ford-Johnson) over any random-access container, with
+// Compare as the strict weak order on its elements. Elements are compared
+// in pairs and the larger ones are sorted recursively; with the partner of
+// the smallest they form the main chain. The remaining partners are
+// inserted in Jacobsthal groups, each group from its highest index down,
+// by binary search over the chain up to the element's own partner.
+//
+// Each level yields the ranks of its elements rather than moving them,
+// so the result is first a permutation, and the pair winners are handed
+// to the next level as MergeInsertionHandle values. sort() then moves
+// each element to its place by following the permutation's cycles with
+// swap: no element is copied, and a type whose swap is cheap (a string, a
+// vector, or a record that specializes swap) is never deep-copied.
+template <typename Container, typename Compare = std::less<typename Container::value_type> >
+class MergeInsertion {
+public:
+    typedef typename Container::value_type value_type;
+    typedef MergeInsertionHandle<value_type> Handle;
+
+    MergeInsertion() : _compare() {}
+    explicit MergeInsertion(const Compare& compare) : _compare(compare) {}
+    MergeInsertion(const MergeInsertion& other) : _compare(other._compare) {}
+    MergeInsertion& operator=(const MergeInsertion& other) {
+        if (this != &other) {
+            _compare = other._compare;
+        }
+        return *this;
+    }
+    ~MergeInsertion() {}
+
+    void sort(Container& items) {
+        std::vector<size_t> permutation;
+        order(items, permutation);
+        applyPermutation(items, permutation);
+    }
+
+    // Stores in permutation the positions of items in ascending order.
+    void order(const Container& items, std::vector<size_t>& permutation) {
+        sortLevel(items, permutation);
+    }
+
+    // The same for items[first] to items[last - 1]; the positions are
+    // relative to first.
+    void order(const Container& items, size_t first, size_t last, std::vector<size_t>& permutation) {
+        MergeInsertionRange<Container> range;
+        range.items = &items;
+        range.first = first;
+        range.last = last;
+        sortLevel(range, permutation);
+    }
+
+    // Jacobsthal numbers 1, 3, 5, 11, 21, ... up to the first value not
+    // below n. Pending element t(k-1) + 1 to t(k) form group k; inserting
+    // each group from the top keeps every binary search within 2^k - 1
+    // elements.
+    static std::vector<size_t> generateJacobsthalSequence(size_t n) {
+        std::vector<size_t> sequence;
+        size_t previous = 1;
+        size_t current = 1;
+        sequence.push_back(current);
+        while (current < n) {
+            size_t next = current + 2 * previous;
+            previous = current;
+            current = next;
+            sequence.push_back(current);
+        }
+        return sequence;
+    }
+
+private:
+    typedef std::vector<typename Handle::type> Level;
+
+    template <typename Sequence>
+    bool less(const Sequence& items, size_t first, size_t second) {
+        return _compare(Handle::get(items[first]), Handle::get(items[second]));
+    }
+
+    // The number of chain entries below bound that name an element less
+    // than items[element].
+    template <typename Sequence>
+    size_t search(const Sequence& items, const MainChain& chain, size_t bound, size_t element) {
+        size_t low = 0;
+        size_t high = bound;
+        while (low < high) {
+            if (high - low <= chain.blockCapacity()) {
+                // Once the range lies within one block, search it in place.
+                size_t count;
+                const size_t* run = chain.run(low, count);
+                if (count >= high - low) {
+                    size_t base = low;
+                    high -= base;
+                    low = 0;
+                    while (low < high) {
+                        size_t middle = low + (high - low) / 2;
+                        if (less(items, run[middle], element)) {
+                            low = middle + 1;
+                        } else {
+                            high = middle;
+                        }
+                    }
+                    return base + low;
+                }
+            }
+            size_t middle = low + (high - low) / 2;
+            if (less(items, chain[middle], element)) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    // Stores in ranks the positions of items in ascending order. The first
+    // level reads the caller's container and every deeper one a Level of
+    // handles. The chain holds positions, so a partner is found by
+    // identity and every search range is exact.
+    template <typename Sequence>
+    void sortLevel(const Sequence& items, std::vector<size_t>& ranks) {
+        size_t n = items.size();
+        ranks.clear();
+        if (n == 0) return;
+        if (n == 1) {
+            ranks.push_back(0);
+            return;
+        }
+
+        size_t pairs = n / 2;
+        Level larger;
+        larger.reserve(pairs);
+        std::vector<size_t> largerIndex(pairs);
+        std::vector<size_t> smallerIndex(pairs);
+        for (size_t i = 0; i < pairs; ++i) {
+            size_t first = 2 * i;
+            size_t second = first + 1;
+            if (less(items, second, first)) std::swap(first, second);
+            smallerIndex[i] = first;
+            largerIndex[i] = second;
+            larger.push_back(Handle::make(Handle::get(items[second])));
+        }
+
+        std::vector<size_t> pairOrder;
+        sortLevel(larger, pairOrder);
+
+        // a[j] and b[j] (from 1) are the larger and smaller element of the
+        // j-th smallest pair; an unpaired last element is b[pairs + 1].
+        std::vector<size_t> a(pairs + 1);
+        std::vector<size_t> b(pairs + 2);
+        for (size_t j = 1; j <= pairs; ++j) {
+            a[j] = largerIndex[pairOrder[j - 1]];
+            b[j] = smallerIndex[pairOrder[j - 1]];
+        }
+        size_t pending = pairs;
+        if (n % 2 != 0) b[++pending] = n - 1;
+
+        std::vector<size_t> initial;
+        initial.reserve(pairs + 1);
+        initial.push_back(b[1]);
+        for (size_t j = 1; j <= pairs; ++j) {
+            initial.push_back(a[j]);
+        }
+        // A short level fits in one block sized to it, which never splits;
+        // the deeper levels are all short.
+        MainChain chain(std::min(n + 2, static_cast<size_t>(MainChain::defaultBlockCapacity)));
+        chain.assign(initial);
+
+        std::vector<size_t> groups = generateJacobsthalSequence(pending);
+        size_t previous = 1;
+        for (size_t g = 1; g < groups.size() && previous < pending; ++g) {
+            size_t last = std::min(groups[g], pending);
+            // Before the group, a[last] is preceded by b[1], a[1..last-1]
+            // and b[2..previous]; the unpaired element may go anywhere.
+            size_t bound = last <= pairs ? last + previous - 1 : chain.size();
+            for (size_t j = last; j > previous; --j) {
+                if (j != last) {
+                    // a[j] precedes a[j + 1], which the last insertion
+                    // moved to bound + 1; only elements inserted since lie
+                    // in between.
+                    while (chain[bound] != a[j]) --bound;
+                }
+                size_t position = search(items, chain, bound, b[j]);
+                chain.insert(position, b[j]);
+            }
+            previous = last;
+        }
+        chain.materialize(ranks);
+    }
+
+    Compare _compare;
+};
+
+#endif // MERGEINSERTION_HPP
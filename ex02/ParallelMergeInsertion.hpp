@@ -0,0 +1,275 @@
+#ifndef PARALLELMERGEINSERTION_HPP
+#define PARALLELMERGEINSERTION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <pthread.h>
+#include "MergeInsertion.hpp"
+
+// Merge-insertion on a pool of threads. The input is cut into one
+// contiguous partition per thread and every thread merge-inserts its own.
+// The sorted runs are then merged in pairs, round after round; each round
+// splits its whole output into one equal slice per thread, and a thread
+// finds where its slice starts in both runs by binary search (merge
+// path), so the merges of a round run in parallel however unequal they
+// are. Merging two runs of m elements takes at most 2m - 1 comparisons,
+// close to the information-theoretic minimum, so the total stays near
+// that of merge-insertion on the whole input.
+//
+// The threads are started once per sort and kept for all its phases; the
+// calling thread is worker 0. Thread w compares with comparator(w)
+// throughout, so a comparator with state (such as a counter) can be given
+// one copy per thread. Like MergeInsertion, the threads work on positions
+// and sort() places the elements at the end, on the calling thread.
+template <typename Container, typename Compare = std::less<typename Container::value_type> >
+class ParallelMergeInsertion {
+public:
+    typedef typename Container::value_type value_type;
+
+    explicit ParallelMergeInsertion(int threadCount, const Compare& compare = Compare())
+        : _items(NULL), _comparators(threadCount < 1 ? 1 : threadCount, compare), _phase(PHASE_SORT),
+          _generation(0), _pending(0), _quit(false) {
+        initSync();
+    }
+    ParallelMergeInsertion(const ParallelMergeInsertion& other)
+        : _items(NULL), _comparators(other._comparators), _phase(PHASE_SORT),
+          _generation(0), _pending(0), _quit(false) {
+        initSync();
+    }
+    ParallelMergeInsertion& operator=(const ParallelMergeInsertion& other) {
+        if (this != &other) {
+            _comparators = other._comparators;
+        }
+        return *this;
+    }
+    ~ParallelMergeInsertion() {
+        pthread_cond_destroy(&_phaseDone);
+        pthread_cond_destroy(&_phaseStarted);
+        pthread_mutex_destroy(&_mutex);
+    }
+
+    size_t threadCount() const { return _comparators.size(); }
+    Compare& comparator(size_t worker) { return _comparators[worker]; }
+
+    void sort(Container& items) {
+        std::vector<size_t> permutation;
+        order(items, permutation);
+        applyPermutation(items, permutation);
+    }
+
+    // Stores in permutation the positions of items in ascending order.
+    void order(const Container& items, std::vector<size_t>& permutation) {
+        size_t n = items.size();
+        size_t threads = _comparators.size();
+        _items = &items;
+        _runs.resize(n);
+        _merged.resize(n);
+        _bounds.clear();
+        for (size_t w = 0; w <= threads; ++w) {
+            _bounds.push_back(n * w / threads);
+        }
+
+        startWorkers();
+        _phase = PHASE_SORT;
+        runPhase();
+        _phase = PHASE_MERGE;
+        while (_bounds.size() > 2) {
+            runPhase();
+            _runs.swap(_merged);
+            std::vector<size_t> bounds;
+            for (size_t r = 0; r + 1 < _bounds.size(); r += 2) {
+                bounds.push_back(_bounds[r]);
+            }
+            bounds.push_back(n);
+            _bounds.swap(bounds);
+        }
+        stopWorkers();
+        permutation.swap(_runs);
+        _items = NULL;
+    }
+
+private:
+    enum Phase { PHASE_SORT, PHASE_MERGE };
+
+    struct Task {
+        ParallelMergeInsertion* sorter;
+        size_t worker;
+        pthread_t thread;
+    };
+
+    const Container* _items;
+    std::vector<Compare> _comparators;
+    // Run r holds positions _runs[_bounds[r]] to _runs[_bounds[r + 1] - 1].
+    std::vector<size_t> _bounds;
+    std::vector<size_t> _runs;
+    std::vector<size_t> _merged;
+    Phase _phase;
+
+    // Workers 1 and up, and which of them got a thread. A phase is started
+    // by bumping _generation; _pending counts the threads still in it.
+    std::vector<Task> _tasks;
+    std::vector<bool> _started;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _phaseStarted;
+    pthread_cond_t _phaseDone;
+    size_t _generation;
+    size_t _pending;
+    bool _quit;
+
+    void initSync() {
+        pthread_mutex_init(&_mutex, NULL);
+        pthread_cond_init(&_phaseStarted, NULL);
+        pthread_cond_init(&_phaseDone, NULL);
+    }
+
+    void runTask(size_t worker) {
+        if (_phase == PHASE_SORT) {
+            sortPartition(worker);
+        } else {
+            mergeSlice(worker);
+        }
+    }
+
+    // A worker thread: runs its task once per phase until told to quit.
+    static void* work(void* arg) {
+        Task& task = *static_cast<Task*>(arg);
+        ParallelMergeInsertion& sorter = *task.sorter;
+        size_t seen = 0;
+        pthread_mutex_lock(&sorter._mutex);
+        while (true) {
+            while (sorter._generation == seen && !sorter._quit) {
+                pthread_cond_wait(&sorter._phaseStarted, &sorter._mutex);
+            }
+            if (sorter._quit) break;
+            seen = sorter._generation;
+            pthread_mutex_unlock(&sorter._mutex);
+            sorter.runTask(task.worker);
+            pthread_mutex_lock(&sorter._mutex);
+            if (--sorter._pending == 0) {
+                pthread_cond_signal(&sorter._phaseDone);
+            }
+        }
+        pthread_mutex_unlock(&sorter._mutex);
+        return NULL;
+    }
+
+    // A worker whose thread cannot be created has its tasks run on the
+    // calling thread instead.
+    void startWorkers() {
+        size_t threads = _comparators.size();
+        _tasks.assign(threads, Task());
+        _started.assign(threads, false);
+        _generation = 0;
+        _quit = false;
+        for (size_t w = 1; w < threads; ++w) {
+            _tasks[w].sorter = this;
+            _tasks[w].worker = w;
+            _started[w] = pthread_create(&_tasks[w].thread, NULL, &ParallelMergeInsertion::work, &_tasks[w]) == 0;
+        }
+    }
+
+    void stopWorkers() {
+        pthread_mutex_lock(&_mutex);
+        _quit = true;
+        pthread_cond_broadcast(&_phaseStarted);
+        pthread_mutex_unlock(&_mutex);
+        for (size_t w = 1; w < _tasks.size(); ++w) {
+            if (_started[w]) pthread_join(_tasks[w].thread, NULL);
+        }
+    }
+
+    // Runs the phase's task for every worker and returns once all are done.
+    void runPhase() {
+        size_t threads = _comparators.size();
+        pthread_mutex_lock(&_mutex);
+        _pending = 0;
+        for (size_t w = 1; w < threads; ++w) {
+            if (_started[w]) ++_pending;
+        }
+        ++_generation;
+        pthread_cond_broadcast(&_phaseStarted);
+        pthread_mutex_unlock(&_mutex);
+
+        runTask(0);
+        for (size_t w = 1; w < threads; ++w) {
+            if (!_started[w]) runTask(w);
+        }
+
+        pthread_mutex_lock(&_mutex);
+        while (_pending > 0) {
+            pthread_cond_wait(&_phaseDone, &_mutex);
+        }
+        pthread_mutex_unlock(&_mutex);
+    }
+
+    void sortPartition(size_t worker) {
+        size_t first = _bounds[worker];
+        size_t last = _bounds[worker + 1];
+        std::vector<size_t> ranks;
+        MergeInsertion<Container, Compare> sorter(_comparators[worker]);
+        sorter.order(*_items, first, last, ranks);
+        for (size_t i = 0; i < ranks.size(); ++i) {
+            _runs[first + i] = first + ranks[i];
+        }
+    }
+
+    bool less(size_t worker, size_t first, size_t second) {
+        return _comparators[worker]((*_items)[first], (*_items)[second]);
+    }
+
+    // How many of the first count elements of the merge of a[0..aSize)
+    // and b[0..bSize) come from a; ties go to a.
+    size_t split(size_t worker, const size_t* a, size_t aSize, const size_t* b, size_t bSize, size_t count) {
+        size_t low = count > bSize ? count - bSize : 0;
+        size_t high = std::min(count, aSize);
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (less(worker, b[count - middle - 1], a[middle])) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        return low;
+    }
+
+    // Writes the worker's slice of this round's output: the runs are
+    // merged in pairs 0-1, 2-3, ..., and an odd last run is copied.
+    void mergeSlice(size_t worker) {
+        size_t n = _runs.size();
+        size_t threads = _comparators.size();
+        size_t sliceBegin = n * worker / threads;
+        size_t sliceEnd = n * (worker + 1) / threads;
+        for (size_t r = 0; r + 1 < _bounds.size(); r += 2) {
+            size_t begin = _bounds[r];
+            size_t middle = _bounds[r + 1];
+            size_t end = r + 2 < _bounds.size() ? _bounds[r + 2] : middle;
+            if (end <= sliceBegin || begin >= sliceEnd) continue;
+
+            const size_t* a = &_runs[0] + begin;
+            const size_t* b = &_runs[0] + middle;
+            size_t aSize = middle - begin;
+            size_t bSize = end - middle;
+            size_t from = std::max(begin, sliceBegin) - begin;
+            size_t to = std::min(end, sliceEnd) - begin;
+            size_t i = split(worker, a, aSize, b, bSize, from);
+            size_t iEnd = split(worker, a, aSize, b, bSize, to);
+            size_t j = from - i;
+            size_t jEnd = to - iEnd;
+            size_t* out = &_merged[0] + begin + from;
+            while (i < iEnd && j < jEnd) {
+                if (less(worker, b[j], a[i])) {
+                    *out++ = b[j++];
+                } else {
+                    *out++ = a[i++];
+                }
+            }
+            out = std::copy(a + i, a + iEnd, out);
+            std::copy(b + j, b + jEnd, out);
+        }
+    }
+};
+
+#endif // PARALLELMERGEINSERTION_HPP
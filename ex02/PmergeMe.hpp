@@ -5,11 +5,11 @@
 #include <string>
 #include <vector>
 #include <deque>
-#include <list> // Potentially used for pair storage or pending elements
-#include <utility> // For std::pair
 #include <sys/time.h> // For timing
 #include <stdexcept>
 #include <limits> // Required for numeric_limits
+#include "MergeInsertion.hpp"
+#include "ParallelMergeInsertion.hpp"
 
 // C++98 doesn't have std::clock_gettime, use gettimeofday
 long long getTimeMicros();
@@ -19,9 +19,20 @@ private:
     std::vector<int> _inputSequence;
     std::vector<int> _sortedVector;
     std::deque<int>  _sortedDeque;
+    std::vector<int> _sortedParallel;
 
     long long _timeVector;
     long long _timeDeque;
+    long long _timeParallel;
+
+    // Threads for the parallel vector sort; 0 skips it.
+    int _threads;
+
+    // Comparisons made by the sort in progress, and by each finished one.
+    size_t _comparisons;
+    size_t _comparisonsVector;
+    size_t _comparisonsDeque;
+    size_t _comparisonsParallel;
 
     PmergeMe(); 
     PmergeMe(const PmergeMe& other);
@@ -31,38 +42,41 @@ private:
     void parseInput(int argc, char **argv);
     bool isValidInput(const char* str, int& value);
 
-    // --- Vector Implementation ---
-    void mergeInsertSortVector(std::vector<int>& vec);
-    // Helper functions for vector sort (e.g., insertion, pair handling)
-    typedef std::vector<std::pair<int, int> > VectorPairVec;
-    void insertSortVectorPairs(VectorPairVec& pairs);
-    void mergeVector(std::vector<int>& mainChain, std::vector<int>& pending);
-    std::vector<int>::iterator binarySearchInsertPosVector(std::vector<int>& vec, int target, std::vector<int>::iterator end);
-
+    // Compares ints, counting every comparison in *count.
+    class CountingLess {
+    public:
+        explicit CountingLess(size_t* count);
+        bool operator()(int a, int b) const;
+    private:
+        size_t* _count;
+    };
 
-    // --- Deque Implementation ---
+    // Both containers are sorted by MergeInsertion.
+    void mergeInsertSortVector(std::vector<int>& vec);
     void mergeInsertSortDeque(std::deque<int>& deq);
-    // Helper functions for deque sort
-     typedef std::deque<std::pair<int, int> > DequePairVec;
-    void insertSortDequePairs(DequePairVec& pairs);
-    void mergeDeque(std::deque<int>& mainChain, std::vector<int>& pending);
-     std::deque<int>::iterator binarySearchInsertPosDeque(std::deque<int>& deq, int target, std::deque<int>::iterator end);
-
-
-    // Jacobsthal numbers (or sequence for insertion order)
-    static std::vector<int> generateJacobsthalSequence(int n);
+    void mergeInsertSortParallel(std::vector<int>& vec);
 
 public:
     explicit PmergeMe(int argc, char **argv);
     ~PmergeMe();
 
+    void setThreadCount(int threads);
     void sortAndMeasure();
     void printResults() const;
+    void printComparisons() const;
+
+    static size_t fordJohnsonBound(size_t n);
 
     class InvalidInputException : public std::exception {
     public:
         virtual const char* what() const throw();
     };
+
+    // The deque or threaded sort disagreed with the vector sort.
+    class SortMismatchException : public std::exception {
+    public:
+        virtual const char* what() const throw();
+    };
 };
 
 #endif // PMERGEME_HPP
@@ -0,0 +1,594 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include "MainChain.hpp"
+#include "MergeInsertion.hpp"
+#include "KeyedMergeInsertion.hpp"
+#include "ParallelMergeInsertion.hpp"
+#include "PmergeMe.hpp"
+
+// Benchmarks for merge-insertion. Elements count their copies and the
+// comparator counts its calls and can spin for a given time on each, to
+// model keys that are expensive to compare. Each sort is timed by
+// timeSort(), which also checks the result.
+//
+// shapes   merge-insertion against std::sort, std::stable_sort and binary
+//          insertion on every input shape and size: comparisons, moves
+//          (copy constructions and assignments) and ns/element, then the
+//          comparator cost above which merge-insertion is the fastest of
+//          the four. Binary insertion moves a quadratic number of
+//          elements and is skipped above insertionLimit.
+// records  records of 8 B to 1 KB keyed by a random long long, with
+//          MergeInsertion on the records and with KeyedMergeInsertion,
+//          which sorts extracted keys and then places each record once:
+//          record copies per record and the MB of record data copied.
+// chain    a MainChain and a std::vector of half the size grown to the
+//          full size by insertions at random ranks, as merge-insertion
+//          grows its main chain: ns per insertion.
+// threads  ParallelMergeInsertion on random ints for 1, 2, 4, 8 threads
+//          and on up to the number of processors: ns/element, speedup
+//          over one thread, and comparisons against the Ford-Johnson
+//          bound F(n), which only one thread is sure to stay within.
+//
+// ./PmergeMe_bench [--cost ns] [section...] [size...]
+
+static size_t comparisons = 0;
+static size_t moves = 0;
+static unsigned long spinsPerComparison = 0;
+
+static const size_t insertionLimit = 30000;
+static const long long minimumNanos = 20000000;
+static const size_t minimumRuns = 3;
+
+// Set from the command line.
+static double costNanos = 0;
+static std::vector<size_t> sizes;
+static bool failed = false;
+
+struct Element {
+    int value;
+
+    Element() : value(0) {}
+    explicit Element(int v) : value(v) {}
+    Element(const Element& other) : value(other.value) { ++moves; }
+    Element& operator=(const Element& other) {
+        ++moves;
+        value = other.value;
+        return *this;
+    }
+    ~Element() {}
+};
+
+struct CostlyLess {
+    bool operator()(const Element& a, const Element& b) const {
+        ++comparisons;
+        for (volatile unsigned long i = 0; i < spinsPerComparison; ++i) {}
+        return a.value < b.value;
+    }
+};
+
+typedef std::vector<Element> Sequence;
+
+// Size bytes, the key in the first of them and the payload after it.
+template <size_t Size>
+struct Record {
+    unsigned char bytes[Size];
+
+    Record() { std::memset(bytes, 0, Size); }
+    explicit Record(long long key) {
+        std::memset(bytes, static_cast<int>(key & 0xFF), Size);
+        std::memcpy(bytes, &key, sizeof(key));
+    }
+    Record(const Record& other) {
+        std::memcpy(bytes, other.bytes, Size);
+        ++moves;
+    }
+    Record& operator=(const Record& other) {
+        ++moves;
+        std::memcpy(bytes, other.bytes, Size);
+        return *this;
+    }
+    ~Record() {}
+
+    long long key() const {
+        long long key;
+        std::memcpy(&key, bytes, sizeof(key));
+        return key;
+    }
+};
+
+template <size_t Size>
+struct RecordLess {
+    bool operator()(const Record<Size>& a, const Record<Size>& b) const {
+        ++comparisons;
+        return a.key() < b.key();
+    }
+};
+
+template <size_t Size>
+struct RecordKey {
+    typedef long long key_type;
+
+    long long operator()(const Record<Size>& record) const { return record.key(); }
+};
+
+struct KeyLess {
+    bool operator()(long long a, long long b) const {
+        ++comparisons;
+        return a < b;
+    }
+};
+
+static int keyOf(const Element& element) {
+    return element.value;
+}
+
+template <size_t Size>
+static long long keyOf(const Record<Size>& record) {
+    return record.key();
+}
+
+static long long nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// The fastest of at least minimumRuns runs of task(), lasting minimumNanos
+// in all, in ns.
+template <typename Task>
+static long long fastest(Task& task) {
+    long long elapsed = 0;
+    long long best = 0;
+    size_t runs = 0;
+    while (runs < minimumRuns || elapsed < minimumNanos) {
+        long long start = nowNanos();
+        task();
+        long long run = nowNanos() - start;
+        elapsed += run;
+        if (runs++ == 0 || run < best) best = run;
+    }
+    return best;
+}
+
+// Spin iterations per nanosecond of comparator cost, timed through the
+// comparator itself so that the loop runs as it does in the sorts; the
+// fastest of five rounds with and without spinning is kept.
+static double calibrateSpins() {
+    const unsigned long spins = 1000;
+    const int calls = 100000;
+    CostlyLess less;
+    Element a(1);
+    Element b(2);
+    long long elapsed[2] = { 0, 0 };
+    for (int round = 0; round < 10; ++round) {
+        spinsPerComparison = round % 2 == 0 ? 0 : spins;
+        long long start = nowNanos();
+        for (int i = 0; i < calls; ++i) {
+            less(a, b);
+        }
+        long long time = nowNanos() - start;
+        if (round < 2 || time < elapsed[round % 2]) elapsed[round % 2] = time;
+    }
+    spinsPerComparison = 0;
+    double nanosPerSpin = static_cast<double>(elapsed[1] - elapsed[0]) / calls / spins;
+    return nanosPerSpin > 0 ? 1 / nanosPerSpin : 1;
+}
+
+enum Shape { SHAPE_RANDOM, SHAPE_SORTED, SHAPE_REVERSE, SHAPE_FEW_UNIQUE, SHAPE_ORGAN_PIPE, SHAPE_COUNT };
+
+static const char* const shapeNames[SHAPE_COUNT] = { "random", "sorted", "reverse", "few-unique", "organ-pipe" };
+
+static Sequence makeInput(Shape shape, size_t n) {
+    Sequence input;
+    input.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        int value;
+        switch (shape) {
+        case SHAPE_RANDOM: value = std::rand(); break;
+        case SHAPE_SORTED: value = static_cast<int>(i); break;
+        case SHAPE_REVERSE: value = static_cast<int>(n - i); break;
+        case SHAPE_FEW_UNIQUE: value = std::rand() % 8; break;
+        default: value = static_cast<int>(i < n / 2 ? i : n - i); break;
+        }
+        input.push_back(Element(value));
+    }
+    return input;
+}
+
+static void mergeInsertion(Sequence& items) {
+    MergeInsertion<Sequence, CostlyLess> sorter;
+    sorter.sort(items);
+}
+
+static void standardSort(Sequence& items) {
+    std::sort(items.begin(), items.end(), CostlyLess());
+}
+
+static void stableSort(Sequence& items) {
+    std::stable_sort(items.begin(), items.end(), CostlyLess());
+}
+
+// Each element is placed after the equal ones already sorted, found by
+// binary search, and the larger ones are shifted up by one.
+static void binaryInsertion(Sequence& items) {
+    CostlyLess less;
+    for (size_t i = 1; i < items.size(); ++i) {
+        Sequence::iterator place = std::upper_bound(items.begin(), items.begin() + i, items[i], less);
+        if (place == items.begin() + i) continue;
+        Element held = items[i];
+        std::copy_backward(place, items.begin() + i, items.begin() + i + 1);
+        *place = held;
+    }
+}
+
+template <size_t Size>
+static void recordMergeInsertion(std::vector<Record<Size> >& records) {
+    MergeInsertion<std::vector<Record<Size> >, RecordLess<Size> > sorter;
+    sorter.sort(records);
+}
+
+template <size_t Size>
+static void keyedMergeInsertion(std::vector<Record<Size> >& records) {
+    KeyedMergeInsertion<std::vector<Record<Size> >, RecordKey<Size>, KeyLess> sorter;
+    sorter.sort(records);
+}
+
+enum Algorithm { ALGORITHM_MERGE_INSERTION, ALGORITHM_SORT, ALGORITHM_STABLE_SORT, ALGORITHM_INSERTION, ALGORITHM_COUNT };
+
+static const char* const algorithmNames[ALGORITHM_COUNT] = {
+    "merge-insertion", "std::sort", "std::stable_sort", "binary insertion"
+};
+
+static void (*const algorithms[ALGORITHM_COUNT])(Sequence&) = {
+    &mergeInsertion, &standardSort, &stableSort, &binaryInsertion
+};
+
+struct Result {
+    bool ran;
+    bool sorted;
+    size_t comparisons;
+    size_t moves;
+    double nanosPerElement;
+};
+
+// The ns/element of the fastest of at least minimumRuns sorts of copies
+// of input, with the comparisons and moves of the first and whether it
+// came out sorted. The time budget is short because the shapes section
+// sorts fifteen inputs per size, some with a spinning comparator.
+template <typename Items>
+static Result timeSort(void (*sort)(Items&), const Items& input) {
+    Result result;
+    result.ran = true;
+    result.sorted = true;
+    result.comparisons = 0;
+    result.moves = 0;
+    result.nanosPerElement = 0;
+
+    long long elapsed = 0;
+    long long fastest = 0;
+    size_t runs = 0;
+    while (runs < minimumRuns || elapsed < minimumNanos) {
+        Items items(input);
+        comparisons = 0;
+        moves = 0;
+        long long start = nowNanos();
+        sort(items);
+        long long run = nowNanos() - start;
+        elapsed += run;
+        if (runs == 0 || run < fastest) fastest = run;
+        if (runs++ == 0) {
+            result.comparisons = comparisons;
+            result.moves = moves;
+            for (size_t i = 1; i < items.size(); ++i) {
+                if (keyOf(items[i]) < keyOf(items[i - 1])) result.sorted = false;
+            }
+        }
+    }
+    result.nanosPerElement = input.empty() ? 0 : static_cast<double>(fastest) / input.size();
+    return result;
+}
+
+static Result measure(Algorithm algorithm, const Sequence& input) {
+    if (algorithm == ALGORITHM_INSERTION && input.size() > insertionLimit) {
+        Result skipped;
+        skipped.ran = false;
+        skipped.sorted = true;
+        skipped.comparisons = 0;
+        skipped.moves = 0;
+        skipped.nanosPerElement = 0;
+        return skipped;
+    }
+    return timeSort(algorithms[algorithm], input);
+}
+
+// The comparator cost, in ns, from which merge-insertion is faster than
+// other, assuming each extra ns of comparator cost adds one ns per
+// comparison: negative when it is already faster, and infinite when it
+// never is.
+static double crossover(const Result& mergeInsertion, const Result& other, size_t n) {
+    double saved = static_cast<double>(other.comparisons) - static_cast<double>(mergeInsertion.comparisons);
+    double slower = (mergeInsertion.nanosPerElement - other.nanosPerElement) * n;
+    if (slower <= 0) return -1;
+    if (saved <= 0) return std::numeric_limits<double>::infinity();
+    return slower / saved;
+}
+
+static std::string formatCrossover(double cost) {
+    char text[32];
+    if (cost < 0) return "always";
+    if (cost == std::numeric_limits<double>::infinity()) return "never";
+    std::snprintf(text, sizeof(text), "%.1f ns", cost);
+    return text;
+}
+
+static void benchShapes() {
+    double spinsPerNano = calibrateSpins();
+
+    // Crossovers come from runs with a free comparator; the table is
+    // measured at the requested cost.
+    std::vector<std::string> crossovers;
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        size_t n = sizes[s];
+        std::printf("n = %lu, comparator cost %.0f ns\n", static_cast<unsigned long>(n), costNanos);
+        std::printf("%-12s %-18s %14s %14s %12s\n", "input", "algorithm", "comparisons", "moves", "ns/element");
+        for (int shape = 0; shape < SHAPE_COUNT; ++shape) {
+            std::srand(42);
+            Sequence input = makeInput(static_cast<Shape>(shape), n);
+            Result free[ALGORITHM_COUNT];
+            for (int a = 0; a < ALGORITHM_COUNT; ++a) {
+                spinsPerComparison = 0;
+                free[a] = measure(static_cast<Algorithm>(a), input);
+                Result result = free[a];
+                if (costNanos > 0) {
+                    spinsPerComparison = static_cast<unsigned long>(costNanos * spinsPerNano + 0.5);
+                    result = measure(static_cast<Algorithm>(a), input);
+                    spinsPerComparison = 0;
+                }
+                if (!result.ran) {
+                    std::printf("%-12s %-18s %14s %14s %12s\n", shapeNames[shape], algorithmNames[a], "-", "-", "-");
+                    continue;
+                }
+                failed |= !result.sorted;
+                std::printf("%-12s %-18s %14lu %14lu %12.1f%s\n", shapeNames[shape], algorithmNames[a],
+                            static_cast<unsigned long>(result.comparisons), static_cast<unsigned long>(result.moves),
+                            result.nanosPerElement, result.sorted ? "" : "  NOT SORTED");
+            }
+
+            double worst = -1;
+            for (int a = 1; a < ALGORITHM_COUNT; ++a) {
+                if (free[a].ran) worst = std::max(worst, crossover(free[ALGORITHM_MERGE_INSERTION], free[a], n));
+            }
+            char line[160];
+            std::snprintf(line, sizeof(line), "%-12s %9lu %14s %18s %18s %14s\n", shapeNames[shape],
+                          static_cast<unsigned long>(n),
+                          formatCrossover(crossover(free[ALGORITHM_MERGE_INSERTION], free[ALGORITHM_SORT], n)).c_str(),
+                          formatCrossover(crossover(free[ALGORITHM_MERGE_INSERTION], free[ALGORITHM_STABLE_SORT], n)).c_str(),
+                          free[ALGORITHM_INSERTION].ran
+                              ? formatCrossover(crossover(free[ALGORITHM_MERGE_INSERTION], free[ALGORITHM_INSERTION], n)).c_str()
+                              : "-",
+                          formatCrossover(worst).c_str());
+            crossovers.push_back(line);
+        }
+        std::printf("\n");
+    }
+
+    std::printf("Comparator cost above which merge-insertion is faster\n");
+    std::printf("%-12s %9s %14s %18s %18s %14s\n", "input", "n", "std::sort", "std::stable_sort", "binary insertion",
+                "all others");
+    for (size_t i = 0; i < crossovers.size(); ++i) {
+        std::printf("%s", crossovers[i].c_str());
+    }
+    std::printf("\n");
+}
+
+template <size_t Size>
+static void benchRecordSize(size_t n) {
+    static const char* const names[2] = { "merge-insertion", "keyed merge-insertion" };
+    void (*const sorts[2])(std::vector<Record<Size> >&) = { &recordMergeInsertion<Size>, &keyedMergeInsertion<Size> };
+
+    std::srand(42);
+    std::vector<Record<Size> > input;
+    input.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        long long key = static_cast<long long>(std::rand()) << 31 | std::rand();
+        input.push_back(Record<Size>(key));
+    }
+    for (int a = 0; a < 2; ++a) {
+        Result result = timeSort(sorts[a], input);
+        failed |= !result.sorted;
+        double perRecord = n == 0 ? 0 : static_cast<double>(result.moves) / n;
+        double megabytes = static_cast<double>(result.moves) * Size / 1000000.0;
+        std::printf("%9lu %7lu B %-22s %14lu %14.2f %10.1f %12.1f%s\n", static_cast<unsigned long>(n),
+                    static_cast<unsigned long>(Size), names[a], static_cast<unsigned long>(result.comparisons),
+                    perRecord, megabytes, result.nanosPerElement, result.sorted ? "" : "  NOT SORTED");
+    }
+}
+
+static void benchRecords() {
+    std::printf("Records keyed by a random long long\n");
+    std::printf("%9s %9s %-22s %14s %14s %10s %12s\n", "n", "record", "algorithm", "comparisons", "copies/record",
+                "MB copied", "ns/element");
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        benchRecordSize<8>(sizes[s]);
+        benchRecordSize<16>(sizes[s]);
+        benchRecordSize<32>(sizes[s]);
+        benchRecordSize<64>(sizes[s]);
+        benchRecordSize<128>(sizes[s]);
+        benchRecordSize<256>(sizes[s]);
+        benchRecordSize<512>(sizes[s]);
+        benchRecordSize<1024>(sizes[s]);
+    }
+    std::printf("\n");
+}
+
+// Keeps results alive so the compiler cannot drop the work.
+static volatile size_t sink = 0;
+
+// Grows initial by inserting at each of ranks in turn, into a MainChain
+// or into a std::vector.
+struct ChainInserts {
+    const std::vector<size_t>* initial;
+    const std::vector<size_t>* ranks;
+    bool plainVector;
+
+    void operator()() const {
+        if (plainVector) {
+            std::vector<size_t> items(*initial);
+            for (size_t i = 0; i < ranks->size(); ++i) {
+                items.insert(items.begin() + (*ranks)[i], i);
+            }
+            sink = sink + items[items.size() / 2];
+        } else {
+            MainChain chain;
+            chain.assign(*initial);
+            for (size_t i = 0; i < ranks->size(); ++i) {
+                chain.insert((*ranks)[i], i);
+            }
+            sink = sink + chain[chain.size() / 2];
+        }
+    }
+};
+
+static void benchChain() {
+    std::printf("Insertions at random ranks into a chain of n / 2 entries\n");
+    std::printf("%9s %-20s %14s\n", "n", "chain", "ns/insertion");
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        size_t n = sizes[s];
+        std::srand(42);
+        std::vector<size_t> initial;
+        for (size_t i = 0; i < n / 2; ++i) {
+            initial.push_back(i);
+        }
+        std::vector<size_t> ranks;
+        for (size_t i = initial.size(); i < n; ++i) {
+            ranks.push_back(static_cast<size_t>(std::rand()) % (i + 1));
+        }
+        for (int c = 0; c < 2; ++c) {
+            ChainInserts task;
+            task.initial = &initial;
+            task.ranks = &ranks;
+            task.plainVector = c == 1;
+            long long best = fastest(task);
+            std::printf("%9lu %-20s %14.1f\n", static_cast<unsigned long>(n), c == 1 ? "std::vector insert" : "MainChain",
+                        ranks.empty() ? 0 : static_cast<double>(best) / ranks.size());
+        }
+    }
+    std::printf("\n");
+}
+
+// Counts in *count, which each thread has its own of.
+struct ThreadCountingLess {
+    size_t* count;
+
+    explicit ThreadCountingLess(size_t* counter = NULL) : count(counter) {}
+    bool operator()(int a, int b) const {
+        ++*count;
+        return a < b;
+    }
+};
+
+// Sorts a copy of input on threads threads; counts receives each
+// thread's comparisons from the last run.
+struct ParallelSort {
+    const std::vector<int>* input;
+    int threads;
+    std::vector<size_t> counts;
+    std::vector<int> sorted;
+
+    void operator()() {
+        counts.assign(threads, 0);
+        sorted = *input;
+        ParallelMergeInsertion<std::vector<int>, ThreadCountingLess> sorter(threads);
+        for (int w = 0; w < threads; ++w) {
+            sorter.comparator(w) = ThreadCountingLess(&counts[w]);
+        }
+        sorter.sort(sorted);
+    }
+};
+
+static void benchThreads() {
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    std::vector<int> threadCounts;
+    for (int t = 1; t <= 8 || t < processors; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    if (processors > threadCounts.back()) threadCounts.push_back(static_cast<int>(processors));
+
+    std::printf("Threaded merge-insertion, random ints, %ld processors\n", processors);
+    std::printf("%9s %8s %12s %9s %14s %10s\n", "n", "threads", "ns/element", "speedup", "comparisons", "of F(n)");
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        size_t n = sizes[s];
+        std::srand(42);
+        std::vector<int> input;
+        for (size_t i = 0; i < n; ++i) {
+            input.push_back(std::rand());
+        }
+        std::vector<int> expected(input);
+        std::sort(expected.begin(), expected.end());
+        double bound = static_cast<double>(PmergeMe::fordJohnsonBound(n));
+
+        double single = 0;
+        for (size_t t = 0; t < threadCounts.size(); ++t) {
+            ParallelSort task;
+            task.input = &input;
+            task.threads = threadCounts[t];
+            double nanosPerElement = n == 0 ? 0 : static_cast<double>(fastest(task)) / n;
+            if (t == 0) single = nanosPerElement;
+            size_t total = 0;
+            for (size_t w = 0; w < task.counts.size(); ++w) {
+                total += task.counts[w];
+            }
+            bool sorted = task.sorted == expected;
+            failed |= !sorted;
+            std::printf("%9lu %8d %12.1f %8.2fx %14lu %9.3fx%s\n", static_cast<unsigned long>(n), threadCounts[t],
+                        nanosPerElement, nanosPerElement > 0 ? single / nanosPerElement : 0,
+                        static_cast<unsigned long>(total), bound > 0 ? total / bound : 0, sorted ? "" : "  NOT SORTED");
+        }
+    }
+    std::printf("\n");
+}
+
+struct Section {
+    const char* name;
+    void (*run)();
+};
+
+static const Section sections[] = {
+    { "shapes", &benchShapes },
+    { "records", &benchRecords },
+    { "chain", &benchChain },
+    { "threads", &benchThreads },
+    { NULL, NULL }
+};
+
+int main(int argc, char** argv) {
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--cost" && i + 1 < argc) {
+            costNanos = std::strtod(argv[++i], NULL);
+        } else if (!arg.empty() && std::isdigit(static_cast<unsigned char>(arg[0]))) {
+            sizes.push_back(std::strtoul(argv[i], NULL, 10));
+        } else {
+            names.push_back(arg);
+        }
+    }
+    if (sizes.empty()) {
+        sizes.push_back(1000);
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+    }
+    for (size_t s = 0; sections[s].name; ++s) {
+        bool selected = names.empty() || std::find(names.begin(), names.end(), sections[s].name) != names.end();
+        if (selected) sections[s].run();
+    }
+    return failed ? 1 : 0;
+}
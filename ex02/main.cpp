@@ -1,18 +1,50 @@
 #include "PmergeMe.hpp"
 #include <iostream>
 #include <exception>
+#include <string>
+#include <cstdlib>
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <positive_integer_sequence>" << std::endl;
-        std::cerr << "Error: No input sequence provided." << std::endl;
+    // ./PmergeMe --stats <sequence> also reports the comparison counts;
+    // -j N also sorts the vector on N threads.
+    const char* name = argv[0];
+    bool stats = false;
+    int threads = 0;
+    bool usage = false;
+    while (argc >= 2 && !usage) {
+        std::string option(argv[1]);
+        if (option == "--stats") {
+            stats = true;
+        } else if (option == "-j" && argc >= 3) {
+            char* end;
+            long count = std::strtol(argv[2], &end, 10);
+            usage = *end != '\0' || count < 1 || count > 256;
+            threads = static_cast<int>(count);
+            ++argv;
+            --argc;
+        } else {
+            break;
+        }
+        ++argv;
+        --argc;
+    }
+    if (argc < 2 || usage) {
+        std::cerr << "Usage: " << name << " [--stats] [-j threads] <positive_integer_sequence>" << std::endl;
+        if (!usage) std::cerr << "Error: No input sequence provided." << std::endl;
         return 1;
     }
 
     try {
         PmergeMe sorter(argc, argv);
+        sorter.setThreadCount(threads);
         sorter.sortAndMeasure();
         sorter.printResults();
+        if (stats) {
+            sorter.printComparisons();
+        }
+    } catch (const PmergeMe::SortMismatchException& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     } catch (const PmergeMe::InvalidInputException& e) {
         std::cerr << e.what() << std::endl;
         return 1;
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "PmergeMe.hpp"
+#include "MainChain.hpp"
+#include "MergeInsertion.hpp"
+#include "KeyedMergeInsertion.hpp"
+#include "ParallelMergeInsertion.hpp"
+
+// Regression tests for the merge-insertion sorts; make test builds and
+// runs them. Each check prints what failed, and the exit status is the
+// number of failures.
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+static std::string describe(const std::string& what, size_t n) {
+    std::ostringstream text;
+    text << what << ", n = " << n;
+    return text.str();
+}
+
+struct CountingLess {
+    size_t* count;
+
+    explicit CountingLess(size_t* counter = NULL) : count(counter) {}
+    bool operator()(int a, int b) const {
+        if (count) ++*count;
+        return a < b;
+    }
+};
+
+// Larger than two pointers, so that MergeInsertion refers to it through
+// pointers below the first level; tag tells equal keys apart.
+struct Record {
+    int key;
+    long tag;
+    long padding[2];
+};
+
+struct RecordLess {
+    size_t* count;
+
+    explicit RecordLess(size_t* counter = NULL) : count(counter) {}
+    bool operator()(const Record& a, const Record& b) const {
+        if (count) ++*count;
+        return a.key < b.key;
+    }
+};
+
+struct RecordKey {
+    typedef int key_type;
+
+    int operator()(const Record& record) const { return record.key; }
+};
+
+static std::vector<int> randomInput(size_t n, int range) {
+    std::vector<int> input;
+    for (size_t i = 0; i < n; ++i) {
+        input.push_back(std::rand() % range);
+    }
+    return input;
+}
+
+// The records sorted by key, and the same records as before.
+static bool sortedRecords(std::vector<Record> records, const std::vector<Record>& input) {
+    for (size_t i = 1; i < records.size(); ++i) {
+        if (records[i].key < records[i - 1].key) return false;
+    }
+    std::vector<long> tags;
+    for (size_t i = 0; i < records.size(); ++i) {
+        tags.push_back(records[i].tag * 1000003L + records[i].key);
+    }
+    std::vector<long> expected;
+    for (size_t i = 0; i < input.size(); ++i) {
+        expected.push_back(input[i].tag * 1000003L + input[i].key);
+    }
+    std::sort(tags.begin(), tags.end());
+    std::sort(expected.begin(), expected.end());
+    return tags == expected;
+}
+
+// Every permutation of up to nine distinct elements is sorted within the
+// Ford-Johnson worst case F(n).
+static void testExhaustive() {
+    for (size_t n = 0; n <= 9; ++n) {
+        std::vector<int> permutation;
+        for (size_t i = 0; i < n; ++i) {
+            permutation.push_back(static_cast<int>(i));
+        }
+        std::vector<int> sorted(permutation);
+        bool allSorted = true;
+        size_t most = 0;
+        do {
+            size_t comparisons = 0;
+            std::vector<int> items(permutation);
+            MergeInsertion<std::vector<int>, CountingLess> sorter((CountingLess(&comparisons)));
+            sorter.sort(items);
+            allSorted &= items == sorted;
+            most = std::max(most, comparisons);
+        } while (std::next_permutation(permutation.begin(), permutation.end()));
+        check(allSorted, describe("every permutation sorted", n));
+        check(most <= PmergeMe::fordJohnsonBound(n), describe("comparisons within F(n) on every permutation", n));
+    }
+}
+
+// Random inputs, of distinct-looking and of duplicate-heavy values, in a
+// vector and a deque, against std::sort.
+static void testRandom() {
+    std::srand(42);
+    for (size_t n = 0; n <= 1200; ++n) {
+        for (int duplicates = 0; duplicates < 2; ++duplicates) {
+            std::vector<int> input = randomInput(n, duplicates ? 4 : 1000000);
+            std::vector<int> expected(input);
+            std::sort(expected.begin(), expected.end());
+
+            size_t comparisons = 0;
+            std::vector<int> vec(input);
+            MergeInsertion<std::vector<int>, CountingLess> vectorSorter((CountingLess(&comparisons)));
+            vectorSorter.sort(vec);
+            check(vec == expected, describe(duplicates ? "vector with duplicates" : "vector", n));
+            check(comparisons <= PmergeMe::fordJohnsonBound(n), describe("vector comparisons within F(n)", n));
+
+            std::deque<int> deq(input.begin(), input.end());
+            MergeInsertion<std::deque<int>, CountingLess> dequeSorter;
+            dequeSorter.sort(deq);
+            check(std::equal(deq.begin(), deq.end(), expected.begin()),
+                  describe(duplicates ? "deque with duplicates" : "deque", n));
+        }
+    }
+}
+
+// Records larger than two pointers go through pointer handles; the keyed
+// sort extracts the keys. Both must keep every record.
+static void testRecords() {
+    std::srand(7);
+    for (size_t n = 0; n <= 300; n += 1 + n / 10) {
+        std::vector<Record> input(n);
+        for (size_t i = 0; i < n; ++i) {
+            input[i].key = std::rand() % (n / 2 + 1);
+            input[i].tag = static_cast<long>(i);
+        }
+
+        size_t comparisons = 0;
+        std::vector<Record> direct(input);
+        MergeInsertion<std::vector<Record>, RecordLess> sorter((RecordLess(&comparisons)));
+        sorter.sort(direct);
+        check(sortedRecords(direct, input), describe("records", n));
+        check(comparisons <= PmergeMe::fordJohnsonBound(n), describe("record comparisons within F(n)", n));
+
+        std::vector<Record> keyed(input);
+        KeyedMergeInsertion<std::vector<Record>, RecordKey> keyedSorter;
+        keyedSorter.sort(keyed);
+        check(sortedRecords(keyed, input), describe("keyed records", n));
+    }
+}
+
+// The threaded sort on 1 to 5 threads, including fewer elements than
+// threads.
+static void testParallel() {
+    std::srand(3);
+    for (size_t n = 0; n <= 1200; n += 1 + n / 8) {
+        for (int threads = 1; threads <= 5; ++threads) {
+            std::vector<int> input = randomInput(n, n % 2 ? 8 : 1000000);
+            std::vector<int> expected(input);
+            std::sort(expected.begin(), expected.end());
+            ParallelMergeInsertion<std::vector<int> > sorter(threads);
+            sorter.sort(input);
+            std::ostringstream what;
+            what << threads << " threads";
+            check(input == expected, describe(what.str(), n));
+        }
+    }
+}
+
+// Long enough for the main chain to split its default-sized blocks.
+static void testLarge() {
+    static const size_t n = 200000;
+    std::srand(5);
+    std::vector<int> input = randomInput(n, 1 << 30);
+    std::vector<int> expected(input);
+    std::sort(expected.begin(), expected.end());
+
+    size_t comparisons = 0;
+    std::vector<int> vec(input);
+    MergeInsertion<std::vector<int>, CountingLess> sorter((CountingLess(&comparisons)));
+    sorter.sort(vec);
+    check(vec == expected, describe("large vector", n));
+    check(comparisons <= PmergeMe::fordJohnsonBound(n), describe("large vector comparisons within F(n)", n));
+
+    ParallelMergeInsertion<std::vector<int> > parallel(4);
+    parallel.sort(input);
+    check(input == expected, describe("large vector on 4 threads", n));
+}
+
+// Insertions at random ranks into chains with tiny blocks, so that nearly
+// every few insertions split one, against a plain vector.
+static void testMainChain() {
+    static const size_t capacities[] = { 2, 3, 4, 8, 64 };
+    std::srand(11);
+    for (size_t c = 0; c < 5; ++c) {
+        for (size_t initial = 0; initial <= 40; initial += 13) {
+            std::vector<size_t> model;
+            for (size_t i = 0; i < initial; ++i) {
+                model.push_back(i);
+            }
+            MainChain chain(capacities[c]);
+            chain.assign(model);
+            bool same = true;
+            for (size_t step = 0; step < 600; ++step) {
+                size_t rank = static_cast<size_t>(std::rand()) % (model.size() + 1);
+                model.insert(model.begin() + rank, 1000 + step);
+                chain.insert(rank, 1000 + step);
+                size_t probe = static_cast<size_t>(std::rand()) % model.size();
+                size_t count;
+                const size_t* run = chain.run(probe, count);
+                same &= chain.size() == model.size() && chain[probe] == model[probe]
+                    && count >= 1 && probe + count <= model.size()
+                    && std::equal(run, run + count, model.begin() + probe);
+            }
+            std::vector<size_t> materialized;
+            chain.materialize(materialized);
+            std::ostringstream what;
+            what << "main chain with blocks of " << capacities[c] << ", " << initial << " entries first";
+            check(same && materialized == model, what.str());
+        }
+    }
+}
+
+int main() {
+    testExhaustive();
+    testRandom();
+    testRecords();
+    testParallel();
+    testLarge();
+    testMainChain();
+    if (failures == 0) std::cout << "All tests passed" << std::endl;
+    return failures;
+}